@@ -1,29 +1,28 @@
 // STL includes
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <sstream>
 
+#include <sys/resource.h>
+
 // Must come before any gl.h include
 #include <GL/glew.h>
 
 // VTK includes
 #include <ExternalVTKWidget.h>
+#include <vtkBoundingBox.h>
 #include <vtkCellData.h>
 #include <vtkCompositeDataIterator.h>
+#include <vtkCompositeDataSet.h>
 #include <vtkDataSet.h>
 #include <vtkLookupTable.h>
 #include <vtkMultiBlockDataSet.h>
 #include <vtkPointData.h>
 
 // PV includes
-#include <vtkProcessModule.h>
 #include <vtkSMProxyManager.h>
-#include <vtkSMSessionClient.h>
-#include <vtkNetworkAccessManager.h>
 #include <vtkSMSessionProxyManager.h>
-#include <vtkSMProxySelectionModel.h>
-#include <vtkSMSourceProxy.h>
-#include <vtkSMViewProxy.h>
 #include <vtkSMRenderViewProxy.h>
 #include <vtkNew.h>
 #include <vtkIdTypeArray.h>
@@ -60,13 +59,17 @@
 #include "Contours.h"
 #include "MooseViewer.h"
 #include "mvApplicationState.h"
+#include "mvArrayCache.h"
+#include "mvBlockParallel.h"
 #include "mvContours.h"
 #include "mvGeometry.h"
 #include "ParaView.h"
 #include "mvInteractorTool.h"
 #include "mvMouseRotationTool.h"
 #include "mvOutline.h"
+#include "mvParaViewSync.h"
 #include "mvReader.h"
+#include "mvSeriesStatistics.h"
 #include "mvSlice.h"
 #include "mvVolume.h"
 #include "ScalarWidget.h"
@@ -86,6 +89,9 @@ MooseViewer::MooseViewer(int& argc,char**& argv)
     Histogram(new float[256]),
     IsPlaying(false),
     Loop(false),
+    m_histogramLogScale(false),
+    m_benchmark(false),
+    m_orthoSlices(false),
     mainMenu(NULL),
     m_colorMapCache(new double[256 * 4]),
     opacityValue(NULL),
@@ -128,91 +134,23 @@ void MooseViewer::initialize()
 {
   this->Superclass::initialize();
 
-  // Connect to remote paraview
-    vtkSMSourceProxy* ActiveSources;
-    vtkSMViewProxy* ActiveView;
-
-    std::cout << "Connecting to URL: " << m_url  << '\n';
-
-    vtkNew<vtkSMSessionClient> session;
-    session->Connect(m_url.c_str());
-    vtkIdType id = vtkProcessModule::GetProcessModule()->RegisterSession(session.GetPointer());
-    vtkSMProxyManager* pxm = vtkSMProxyManager::GetProxyManager();//->GetActiveSessionProxyManager();
-    pxm->SetActiveSession(id);
-    if(pxm->GetActiveSession()) {
-      vtkSMSessionClient* activeSession = vtkSMSessionClient::SafeDownCast(pxm->GetActiveSession());
-      if(activeSession->IsMultiClients()&& activeSession->IsNotBusy()) {
-        std::cout<< "Processing remote events" <<std::endl;
-        while(vtkProcessModule::GetProcessModule()->GetNetworkAccessManager()->ProcessEvents(100));
-      }
-   }
-  vtkSMSessionProxyManager* spxm = vtkSMProxyManager::GetProxyManager()->GetActiveSessionProxyManager();
-  std::cout<<"connected"<<spxm<<std::endl;
-  spxm->UpdateFromRemote();
-  // setup the active-view and active-sources selection models.
-  vtkSMProxySelectionModel* selmodel = spxm->GetSelectionModel("ActiveSources");
-  if (selmodel == NULL)
-    {
-    std::cout << "Active Sources not found" << std::endl;
-
-    selmodel = vtkSMProxySelectionModel::New();
-    spxm->RegisterSelectionModel("ActiveSources", selmodel);
-    selmodel->FastDelete();
-    }
-  ActiveSources = vtkSMSourceProxy::SafeDownCast(selmodel->GetCurrentProxy());
-  selmodel = spxm->GetSelectionModel("ActiveView");
-  if (selmodel == NULL)
-    {
-    std::cout << "Active View not found" << std::endl;
-
-    selmodel = vtkSMProxySelectionModel::New();
-    spxm->RegisterSelectionModel("ActiveView", selmodel);
-    selmodel->FastDelete();
-    }
-  ActiveView = vtkSMViewProxy::SafeDownCast(selmodel->GetCurrentProxy());
-
-  //  vtkSMProxy* sphere1 = pxm->NewProxy("sources", "SphereSource");
-//  sphere1->UpdateVTKObjects();
-//  vtkSMProxy* view1 = pxm->NewProxy("views", "RenderView");
-//  view1->UpdateVTKObjects();
-//  vtkSMRenderViewProxy::SafeDownCast(view1)->StillRender();
-//  int foo; cin >> foo;
-//  exit();
-//  sphere1->Delete();
-//  view1->Delete();
-  vtkSMRenderViewProxy *rvp = 0;
-//  vtkSMViewProxy *vp;
-  rvp=vtkSMRenderViewProxy::SafeDownCast(selmodel->GetCurrentProxy());
-  //vp=vtkSMRenderViewProxy::SafeDownCast(rvp);
-  //vp->EnableOff();
-  //rvp->InteractiveRender();
-  rvp->UpdateVTKObjects();
-  rvp->StillRender();
-  //rvp->Update();
-  RVP = rvp;
-  vtkActorCollection* actors;
-  actors = rvp->GetRenderer()->GetActors();
-
-  std::cout<<"total actors = " << actors->GetNumberOfItems()<<std::endl;
-
-  //vtkSMRenderViewProxy::SafeDownCast(pxm->GetProxy("views","RenderView"));
-/*
-  if(rvp)
-    {
-    _renderer = new vtkVRJugglerRenderer(rvp);//vtkSMRenderViewProxy::SafeDownCast(view1));
-    _renderer->OffScreenRenderingOn();
-    rvp->UpdateVTKObjects();
-    rvp->ResetCamera();
-    //rvp->StillRender();
-    }
-  else
+  if (m_orthoSlices)
     {
-    cout<<" Render view proxy not found" <<std::endl;
-    int temp;
-    cin >> temp;
-    return;
+    mvSlice &slice = m_mvState.slice();
+    std::vector<mvSlice::Plane> planes(3, slice.plane());
+    for (size_t axis = 0; axis < planes.size(); ++axis)
+      {
+      planes[axis].normal.fill(0.);
+      planes[axis].normal[axis] = 1.;
+      }
+    slice.setPlanes(planes);
+    slice.setActivePlane(0);
     }
-*/
+
+  // Connect to the ParaView server in the background. The local pipelines
+  // render until the session is up, and if the server can't be reached.
+  std::cout << "Connecting to URL: " << m_url << '\n';
+  m_mvState.paraViewSync().start(m_url);
 
   // Start async file read.
   m_mvState.reader().update(m_mvState);
@@ -298,6 +236,7 @@ const std::string& MooseViewer::getWidgetHintsFile()
 //----------------------------------------------------------------------------
 void MooseViewer::setBenchmark(bool bench)
 {
+  m_benchmark = bench;
   m_mvState.contours().setBenchmark(bench);
   m_mvState.geometry().setBenchmark(bench);
   m_mvState.reader().setBenchmark(bench);
@@ -311,6 +250,76 @@ void MooseViewer::setProgressVisibility(bool vis)
   m_mvState.progress().setVisible(vis);
 }
 
+//----------------------------------------------------------------------------
+void MooseViewer::setPrefetchWindow(int ahead, int behind)
+{
+  m_mvState.reader().setPrefetchAhead(ahead);
+  m_mvState.reader().setPrefetchBehind(behind);
+}
+
+//----------------------------------------------------------------------------
+void MooseViewer::setCacheBudget(size_t bytes)
+{
+  m_mvState.reader().setCacheBudget(bytes);
+}
+
+//----------------------------------------------------------------------------
+void MooseViewer::setImageCacheBudget(size_t bytes)
+{
+  m_mvState.reader().imageCache().setBudget(bytes);
+}
+
+//----------------------------------------------------------------------------
+void MooseViewer::setUseGlobalRanges(bool global)
+{
+  m_mvState.reader().setUseGlobalRanges(global);
+}
+
+//----------------------------------------------------------------------------
+void MooseViewer::setHistogramOptions(int bins, bool logScale)
+{
+  m_mvState.reader().setHistogramBins(bins);
+  m_histogramLogScale = logScale;
+  this->HistogramMTime = vtkTimeStamp();
+}
+
+//----------------------------------------------------------------------------
+void MooseViewer::setLoResBudget(long long voxels, double seconds)
+{
+  m_mvState.reader().setReducerVoxelBudget(voxels);
+  m_mvState.reader().setReducerTimeBudget(seconds);
+}
+
+//----------------------------------------------------------------------------
+void MooseViewer::setBlockParallel(bool enabled)
+{
+  mvBlockParallel::setEnabled(enabled);
+}
+
+//----------------------------------------------------------------------------
+void MooseViewer::setOrthogonalSlices(bool ortho)
+{
+  m_orthoSlices = ortho;
+}
+
+//----------------------------------------------------------------------------
+void MooseViewer::setRemoteLOD(bool lod)
+{
+  m_mvState.paraViewSync().setRemoteLOD(lod);
+}
+
+//----------------------------------------------------------------------------
+bool MooseViewer::disconnectParaView()
+{
+  return m_mvState.paraViewSync().shutdown();
+}
+
+//----------------------------------------------------------------------------
+void MooseViewer::setConnectTimeout(double seconds)
+{
+  m_mvState.paraViewSync().setConnectTimeout(seconds);
+}
+
 //----------------------------------------------------------------------------
 GLMotif::PopupMenu* MooseViewer::createMainMenu(void)
 {
@@ -777,22 +786,19 @@ GLMotif::PopupWindow* MooseViewer::createRenderingDialog(void) {
 //----------------------------------------------------------------------------
 void MooseViewer::frame()
 {
-  // Update events from ParaView
-    vtkSMSessionClient* session = vtkSMSessionClient::SafeDownCast(vtkSMProxyManager::GetProxyManager()->GetActiveSession());
-   if(session->IsMultiClients()&& session->IsNotBusy())
-        {
-        std::cout<< "Processing remote events" <<std::endl;
-        while(vtkProcessModule::GetProcessModule()->GetNetworkAccessManager()->ProcessEvents(100));
-        }
-   std::cout<<"total actors = " << RVP->GetRenderer()->GetActors()->GetNumberOfItems()<<std::endl;
-
-   vtkSMProxyManager::GetProxyManager()->GetActiveSessionProxyManager()->UpdateFromRemote();
-    RVP->UpdateVTKObjects();
-RVP->SynchronizeCameraProperties();
+  // Apply the changes from ParaView:
+  this->syncParaView();
 
   // Update internal state:
   m_mvState.reader().update(m_mvState);
+  if (m_mvState.reader().updateGlobalRanges())
+    {
+    // The histogram bins span the range, so it must be rebuilt:
+    this->HistogramMTime = vtkTimeStamp();
+    this->updateScalarRange();
+    }
   this->updateHistogram();
+  this->reportCacheStatistics();
 
   this->Superclass::frame();
 
@@ -1175,8 +1181,10 @@ float * MooseViewer::getHistogram(void)
 //----------------------------------------------------------------------------
 void MooseViewer::updateHistogram(void)
 {
-  if (this->HistogramMTime > m_mvState.reader().dataObject()->GetMTime() &&
-      this->HistogramMTime > m_mvState.colorByMTime())
+  vtkDataObject *dObj = m_mvState.reader().dataObject();
+  if (!dObj ||
+      (this->HistogramMTime > dObj->GetMTime() &&
+       this->HistogramMTime > m_mvState.colorByMTime()))
     {
     // Up to date.
     return;
@@ -1184,62 +1192,43 @@ void MooseViewer::updateHistogram(void)
 
   std::fill(this->Histogram, this->Histogram + 256, 0.f);
 
-  auto metaData = m_mvState.reader().variableMetaData(m_mvState.colorByArray());
-  if (metaData.valid())
+  // The reader computes the histograms in the background. Resample them to
+  // the 256 entries used by the widgets:
+  mvReader &reader = m_mvState.reader();
+  auto metaData = reader.variableMetaData(m_mvState.colorByArray());
+  std::vector<float> &hist = metaData.histogram;
+
+  // With whole-series ranges, show the whole-series distribution as well:
+  mvSeriesStatistics::Variable series;
+  if (reader.globalRangesApplied() &&
+      reader.seriesStatistics().lookup(m_mvState.colorByArray(), series))
     {
-    vtkCompositeDataIterator *it =
-        m_mvState.reader().typedDataObject()->NewIterator();
-    for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+    hist.assign(series.histogram.begin(), series.histogram.end());
+    }
+  const size_t numBins = hist.size();
+  if (numBins >= 256)
+    {
+    for (size_t bin = 0; bin < numBins; ++bin)
       {
-      vtkDataSet *ds = vtkDataSet::SafeDownCast(it->GetCurrentDataObject());
-      if (!ds)
-        {
-        continue;
-        }
-
-      vtkDataArray *array = nullptr;
-      switch (metaData.location)
-        {
-        case mvReader::VariableMetaData::Location::PointData:
-          array = ds->GetPointData()->GetArray(m_mvState.colorByArray().c_str());
-          break;
-
-        case mvReader::VariableMetaData::Location::CellData:
-          array = ds->GetCellData()->GetArray(m_mvState.colorByArray().c_str());
-          break;
-
-        case mvReader::VariableMetaData::Location::FieldData:
-          array = ds->GetFieldData()->GetArray(m_mvState.colorByArray().c_str());
-          break;
-
-        default:
-          break;
-        }
-
-      if (!array)
-        {
-        continue;
-        }
+      this->Histogram[bin * 256 / numBins] += hist[bin];
+      }
+    }
+  else if (numBins > 0)
+    {
+    for (size_t i = 0; i < 256; ++i)
+      {
+      this->Histogram[i] = hist[i * numBins / 256];
+      }
+    }
 
-      vtkIdType numTuples = array->GetNumberOfTuples();
-      double min = metaData.range[0];
-      double spread = metaData.range[1] - min;
-      if (spread < 1e-6) // Constant data...
-        {
-        continue;
-        }
-      else
-        {
-        for (vtkIdType tuple = 0; tuple < numTuples; ++tuple)
-          {
-          size_t bin = static_cast<size_t>(
-                (array->GetComponent(tuple, 0) - min) * 255. / spread);
-          assert(bin < 256);
-          ++this->Histogram[bin];
-          }
-        }
+  // Scale after resampling, so that merged bins add up their counts. The log
+  // keeps sparse bins visible next to a dominant value:
+  if (m_histogramLogScale)
+    {
+    for (size_t i = 0; i < 256; ++i)
+      {
+      this->Histogram[i] = std::log1p(this->Histogram[i]);
       }
-    it->Delete();
     }
 
   this->HistogramMTime.Modified();
@@ -1249,6 +1238,105 @@ void MooseViewer::updateHistogram(void)
   Vrui::requestUpdate();
 }
 
+//----------------------------------------------------------------------------
+void MooseViewer::syncParaView(void)
+{
+  mvParaViewSync &sync = m_mvState.paraViewSync();
+  m_pvChanges.merge(sync.takeChanges());
+
+  // The sync thread delivers the geometry, mvGeometry mirrors it. Keep the
+  // frames coming until the full resolution has arrived:
+  if (m_pvChanges.delivered || sync.deliveryPending())
+    {
+    Vrui::requestUpdate();
+    }
+  m_pvChanges.delivered = false;
+  if (m_pvChanges.empty())
+    {
+    return;
+    }
+
+  // Don't stall the frame while the sync thread is reading from the server,
+  // the changes are kept for the next frame:
+  std::unique_lock<std::mutex> lock(sync.mutex(), std::try_to_lock);
+  if (!lock.owns_lock())
+    {
+    return;
+    }
+
+  // Keep the changes until a session with a render view is up:
+  if (!RVP)
+    {
+    return;
+    }
+
+  if (m_pvChanges.registration)
+    {
+    vtkSMProxyManager::GetProxyManager()->GetActiveSessionProxyManager()
+        ->UpdateFromRemote();
+    }
+  if (!m_pvChanges.proxies.empty() || m_pvChanges.registration)
+    {
+    RVP->UpdateVTKObjects();
+    }
+  if (m_pvChanges.camera)
+    {
+    RVP->SynchronizeCameraProperties();
+    }
+
+  m_pvChanges = mvParaViewSync::Changes();
+}
+
+//----------------------------------------------------------------------------
+void MooseViewer::reportCacheStatistics(void)
+{
+  vtkDataObject *dObj = m_mvState.reader().dataObject();
+  if (!m_benchmark || !dObj || this->m_cacheReportMTime > dObj->GetMTime())
+    {
+    return;
+    }
+
+  mvArrayCache::Statistics stats =
+      m_mvState.reader().arrayCache().statistics();
+  std::cerr << "Reader cache: " << stats.hits << " hits, "
+            << stats.misses << " misses, "
+            << stats.evictions << " evictions, "
+            << stats.entries << " entries, "
+            << (stats.bytes / (1024 * 1024)) << " / "
+            << (m_mvState.reader().arrayCache().budget() / (1024 * 1024))
+            << " MiB\n";
+
+  mvImageCache::Statistics imageStats =
+      m_mvState.reader().imageCache().statistics();
+  std::cerr << "Image cache: " << imageStats.hits << " hits, "
+            << imageStats.misses << " misses, "
+            << imageStats.evictions << " evictions, "
+            << imageStats.entries << " entries, "
+            << (imageStats.bytes / (1024 * 1024)) << " / "
+            << (m_mvState.reader().imageCache().budget() / (1024 * 1024))
+            << " MiB\n";
+
+  std::cerr << "Static topology: "
+            << (m_mvState.reader().staticTopology() ? "yes" : "no") << "\n";
+
+  // Compare runs with and without -serialBlocks:
+  ParaView::SurfaceStatistics surfaceStats =
+      m_mvState.pvgeometry().surfaceStatistics();
+  std::cerr << "Surfaces: " << surfaceStats.reused << " reused, "
+            << surfaceStats.remapped << " remapped, "
+            << surfaceStats.extracted << " extracted blocks, "
+            << surfaceStats.seconds << " s total\n";
+
+  // ru_maxrss is in KiB on Linux:
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+    std::cerr << "Peak RSS: " << (usage.ru_maxrss / 1024) << " MiB\n";
+    }
+
+  this->m_cacheReportMTime.Modified();
+}
+
 //----------------------------------------------------------------------------
 void MooseViewer::updateScalarRange(void)
 {
@@ -1334,11 +1422,17 @@ void MooseViewer::centerDisplay() const
     double xmin=0.0, xmax=0.0,ymin=0.0,ymax=0.0,zmin=0.0,zmax=0.0;
     double bounds[6];
 
-  vtkActor * pCurActor = NULL;
-  vtkActorCollection* actors = RVP->GetRenderer()->GetActors();
-  actors->InitTraversal();
-  do
+  // Frame the local dataset rather than wait while the ParaView sync thread
+  // is reading from the server:
+  std::unique_lock<std::mutex> pvLock(m_mvState.paraViewSync().mutex(),
+                                      std::try_to_lock);
+  if (pvLock.owns_lock() && RVP)
     {
+    vtkActor * pCurActor = NULL;
+    vtkActorCollection* actors = RVP->GetRenderer()->GetActors();
+    actors->InitTraversal();
+    do
+      {
       pCurActor = actors->GetNextActor();
       if (pCurActor != NULL)
         if(pCurActor->GetMapper() !=NULL)
@@ -1352,6 +1446,44 @@ void MooseViewer::centerDisplay() const
           zmax = (bounds[5]>zmax)?bounds[5]:zmax;
           }
       } while (pCurActor != NULL);
+    }
+  else if (vtkDataObject *dObj = m_mvState.reader().dataObject())
+    {
+    // No server: frame the local dataset.
+    vtkBoundingBox bbox;
+    if (vtkCompositeDataSet *cds = vtkCompositeDataSet::SafeDownCast(dObj))
+      {
+      vtkCompositeDataIterator *iter = cds->NewIterator();
+      for (iter->InitTraversal(); !iter->IsDoneWithTraversal();
+           iter->GoToNextItem())
+        {
+        if (vtkDataSet *ds =
+            vtkDataSet::SafeDownCast(iter->GetCurrentDataObject()))
+          {
+          bbox.AddBounds(ds->GetBounds());
+          }
+        }
+      iter->Delete();
+      }
+    else if (vtkDataSet *ds = vtkDataSet::SafeDownCast(dObj))
+      {
+      bbox.AddBounds(ds->GetBounds());
+      }
+    if (bbox.IsValid())
+      {
+      bbox.GetBounds(bounds);
+      xmin = bounds[0];
+      xmax = bounds[1];
+      ymin = bounds[2];
+      ymax = bounds[3];
+      zmin = bounds[4];
+      zmax = bounds[5];
+      }
+    }
+  if (pvLock.owns_lock())
+    {
+    pvLock.unlock();
+    }
     bounds[0]=xmin;
     bounds[1]=xmax;
     bounds[2]=ymin;
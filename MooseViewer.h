@@ -3,6 +3,7 @@
 
 // MooseViewer includes
 #include "mvApplicationState.h"
+#include "mvParaViewSync.h"
 
 // vtkVRUI includes
 #include <vvApplication.h>
@@ -97,6 +98,21 @@ private:
   /* Custom scalar range */
   double ScalarRange[2];
 
+  /* Show log(1 + count) in the histogram */
+  bool m_histogramLogScale;
+
+  /* Benchmark output */
+  bool m_benchmark;
+  vtkTimeStamp m_cacheReportMTime;
+  void reportCacheStatistics(void);
+
+  /* Slice along the three axes, applied once the slice is initialized */
+  bool m_orthoSlices;
+
+  /* Remote ParaView changes that are not applied yet */
+  mvParaViewSync::Changes m_pvChanges;
+  void syncParaView(void);
+
   /* Constructors and destructors: */
 public:
   using Superclass = vvApplication;
@@ -130,6 +146,47 @@ public:
   // updated.
   void setProgressVisibility(bool vis);
 
+  // Number of timesteps the reader decodes in the background around the
+  // current timestep.
+  void setPrefetchWindow(int ahead, int behind);
+
+  // Memory budget for the reader's decoded variable cache, in bytes.
+  void setCacheBudget(size_t bytes);
+
+  // Memory budget for resampled volumes, in bytes.
+  void setImageCacheBudget(size_t bytes);
+
+  // Color map ranges span the entire time series when enabled.
+  void setUseGlobalRanges(bool global);
+
+  // Resolution of the histograms computed by the reader, and whether the
+  // widgets show them on a log scale.
+  void setHistogramOptions(int bins, bool logScale);
+
+  // Adaptive LoRes resampling: target voxel count (0 = fixed 64^3) and the
+  // time budget in seconds the reducer is scaled to.
+  void setLoResBudget(long long voxels, double seconds);
+
+  // Process the blocks of the HiRes dataset concurrently (default on).
+  void setBlockParallel(bool enabled);
+
+  // Slice along the three axes at once instead of a single plane.
+  void setOrthogonalSlices(bool ortho);
+
+  // Request decimated geometry from the ParaView server before the full
+  // resolution (default on).
+  void setRemoteLOD(bool lod);
+
+  // Close the ParaView session. Must be called before the ServerManager is
+  // finalized, which is only safe if this returns true: false means a
+  // connection attempt is still blocked on the server.
+  bool disconnectParaView();
+
+  // Seconds to wait for the ParaView server before reporting that only the
+  // local pipelines are rendered. The connection is retried in the
+  // background either way.
+  void setConnectTimeout(double seconds);
+
   /* Animation */
   bool IsPlaying;
   bool Loop;
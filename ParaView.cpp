@@ -5,22 +5,162 @@
 #include <vtkActor.h>
 #include <vtkActorCollection.h>
 #include <vtkSMRenderViewProxy.h>
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
 #include <vtkCompositeDataGeometryFilter.h>
+#include <vtkCompositePolyDataMapper2.h>
+#include <vtkDataSet.h>
+#include <vtkDataSetSurfaceFilter.h>
 #include <vtkExodusIIReader.h>
 #include <vtkExternalOpenGLRenderer.h>
+#include <vtkGeometryFilter.h>
+#include <vtkIdList.h>
+#include <vtkIdTypeArray.h>
 #include <vtkLookupTable.h>
 #include <vtkMultiBlockDataSet.h>
-#include <vtkPolyDataMapper.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
 #include <vtkProperty.h>
 #include <vtkRenderer.h>
+#include <vtkUnstructuredGrid.h>
 
 #include <vvContextState.h>
 
 #include "mvApplicationState.h"
+#include "mvBlockParallel.h"
 #include "mvReader.h"
 
+#include <algorithm>
+#include <chrono>
+
 extern vtkSMRenderViewProxy* RVP;
 
+namespace {
+
+const char *OriginalPointIds = "mvOriginalPointIds";
+const char *OriginalCellIds = "mvOriginalCellIds";
+
+//------------------------------------------------------------------------------
+// Move the id array @a name from @a fd into a new id list. Returns nullptr
+// if some entries have no original id.
+vtkSmartPointer<vtkIdList> takeIds(vtkFieldData *fd, const char *name)
+{
+  vtkIdTypeArray *array = vtkIdTypeArray::SafeDownCast(fd->GetArray(name));
+  if (!array)
+    {
+    return nullptr;
+    }
+
+  vtkSmartPointer<vtkIdList> ids = vtkSmartPointer<vtkIdList>::New();
+  const vtkIdType *begin = array->GetPointer(0);
+  const vtkIdType *end = begin + array->GetNumberOfTuples();
+  if (std::any_of(begin, end, [](vtkIdType id) { return id < 0; }))
+    {
+    ids = nullptr;
+    }
+  else
+    {
+    ids->SetNumberOfIds(array->GetNumberOfTuples());
+    std::copy(begin, end, ids->GetPointer(0));
+    }
+  fd->RemoveArray(name);
+  return ids;
+}
+
+//------------------------------------------------------------------------------
+// Gather the tuples @a ids of every array in @a in into @a out:
+void gather(vtkFieldData *in, vtkIdList *ids, vtkFieldData *out)
+{
+  const int numArrays = in->GetNumberOfArrays();
+  for (int i = 0; i < numArrays; ++i)
+    {
+    vtkAbstractArray *array = in->GetAbstractArray(i);
+    vtkSmartPointer<vtkAbstractArray> result;
+    result.TakeReference(array->NewInstance());
+    result->SetName(array->GetName());
+    result->SetNumberOfComponents(array->GetNumberOfComponents());
+    result->SetNumberOfTuples(ids->GetNumberOfIds());
+    array->GetTuples(ids, result);
+    out->AddArray(result);
+    }
+}
+
+} // end anon namespace
+
+//------------------------------------------------------------------------------
+void ParaView::LoResDataPipeline::Surface::extract()
+{
+  vtkUnstructuredGrid *grid = vtkUnstructuredGrid::SafeDownCast(this->block);
+  if (!grid)
+    {
+    vtkNew<vtkGeometryFilter> extract;
+    extract->SetInputData(this->block);
+    extract->Update();
+    this->surface = extract->GetOutput();
+    return;
+    }
+
+  // Record where the surface came from, so that it can be remapped:
+  vtkNew<vtkDataSetSurfaceFilter> extract;
+  extract->SetInputData(grid);
+  extract->PassThroughPointIdsOn();
+  extract->SetOriginalPointIdsName(OriginalPointIds);
+  extract->PassThroughCellIdsOn();
+  extract->SetOriginalCellIdsName(OriginalCellIds);
+  extract->Update();
+  this->surface = extract->GetOutput();
+
+  this->cells = grid->GetCells();
+  this->cellsMTime = this->cells ? this->cells->GetMTime() : 0;
+  this->points = grid->GetPoints();
+  this->pointsMTime = this->points ? this->points->GetMTime() : 0;
+  this->pointIds = takeIds(this->surface->GetPointData(), OriginalPointIds);
+  this->cellIds = takeIds(this->surface->GetCellData(), OriginalCellIds);
+}
+
+//------------------------------------------------------------------------------
+bool ParaView::LoResDataPipeline::Surface::sameTopology(
+    const Surface &other) const
+{
+  vtkUnstructuredGrid *grid = vtkUnstructuredGrid::SafeDownCast(this->block);
+  return
+      grid && other.surface && other.cells && other.points &&
+      other.pointIds && other.cellIds &&
+      grid->GetCells() == other.cells.Get() &&
+      grid->GetCells()->GetMTime() == other.cellsMTime &&
+      grid->GetPoints() &&
+      grid->GetNumberOfPoints() == other.points->GetNumberOfPoints();
+}
+
+//------------------------------------------------------------------------------
+void ParaView::LoResDataPipeline::Surface::remap(const Surface &other)
+{
+  vtkUnstructuredGrid *grid = vtkUnstructuredGrid::SafeDownCast(this->block);
+
+  this->cells = other.cells;
+  this->cellsMTime = other.cellsMTime;
+  this->points = grid->GetPoints();
+  this->pointsMTime = this->points->GetMTime();
+  this->pointIds = other.pointIds;
+  this->cellIds = other.cellIds;
+
+  // Share the polygons, and the points too unless the mesh moved:
+  this->surface = vtkSmartPointer<vtkPolyData>::New();
+  this->surface->CopyStructure(other.surface);
+  if (this->points != other.points || this->pointsMTime != other.pointsMTime)
+    {
+    vtkNew<vtkPoints> points;
+    points->SetDataType(this->points->GetDataType());
+    points->SetNumberOfPoints(this->pointIds->GetNumberOfIds());
+    this->points->GetPoints(this->pointIds, points.Get());
+    this->surface->SetPoints(points.Get());
+    }
+
+  gather(grid->GetPointData(), this->pointIds, this->surface->GetPointData());
+  gather(grid->GetCellData(), this->cellIds, this->surface->GetCellData());
+}
+
 //------------------------------------------------------------------------------
 vtkDataObject *
 ParaView::LoResDataPipeline::input(const vvApplicationState &vvState) const
@@ -56,7 +196,85 @@ bool ParaView::LoResDataPipeline::needsUpdate(const ObjectState &objState,
 //------------------------------------------------------------------------------
 void ParaView::LoResDataPipeline::execute()
 {
-  this->filter->Update();
+  typedef std::chrono::steady_clock Clock;
+  const Clock::time_point start = Clock::now();
+  SurfaceStatistics stats;
+
+  if (!mvBlockParallel::enabled())
+    {
+    this->surfaces.clear();
+    this->filter->Update();
+    vtkDataObject *dObj = this->filter->GetOutputDataObject(0);
+    this->output.TakeReference(dObj->NewInstance());
+    this->output->ShallowCopy(dObj);
+    }
+  else
+    {
+    const std::vector<vtkDataSet*> blocks =
+        mvBlockParallel::blocks(this->filter->GetInputDataObject(0, 0));
+
+    // Reuse the surfaces of unchanged blocks. The others are remapped from the
+    // previous surface of the same block if the topology is unchanged, or
+    // extracted again:
+    std::vector<Surface> result(blocks.size());
+    std::vector<size_t> stale;
+    for (size_t i = 0; i < blocks.size(); ++i)
+      {
+      const Surface *previous =
+          i < this->surfaces.size() ? &this->surfaces[i] : nullptr;
+      if (previous && previous->block.Get() == blocks[i] &&
+          previous->blockMTime == blocks[i]->GetMTime())
+        {
+        result[i] = *previous;
+        ++stats.reused;
+        }
+      else
+        {
+        result[i].block = blocks[i];
+        result[i].blockMTime = blocks[i]->GetMTime();
+        stale.push_back(i);
+        }
+      }
+
+    std::vector<char> remapped(stale.size(), 0);
+    mvBlockParallel::forEach(stale.size(), [&](size_t i)
+      {
+      const size_t block = stale[i];
+      Surface &surface = result[block];
+      if (block < this->surfaces.size() &&
+          surface.sameTopology(this->surfaces[block]))
+        {
+        surface.remap(this->surfaces[block]);
+        remapped[i] = 1;
+        }
+      else
+        {
+        surface.extract();
+        }
+      });
+    stats.remapped = std::count(remapped.begin(), remapped.end(), 1);
+    stats.extracted = stale.size() - stats.remapped;
+
+    vtkSmartPointer<vtkMultiBlockDataSet> pieces =
+        vtkSmartPointer<vtkMultiBlockDataSet>::New();
+    pieces->SetNumberOfBlocks(static_cast<unsigned int>(result.size()));
+    for (size_t i = 0; i < result.size(); ++i)
+      {
+      pieces->SetBlock(static_cast<unsigned int>(i), result[i].surface);
+      }
+    this->surfaces.swap(result);
+    this->output = pieces;
+    }
+
+  stats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  if (this->counters)
+    {
+    std::lock_guard<std::mutex> lock(this->counters->mutex);
+    this->counters->stats.reused += stats.reused;
+    this->counters->stats.remapped += stats.remapped;
+    this->counters->stats.extracted += stats.extracted;
+    this->counters->stats.seconds += stats.seconds;
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -64,9 +282,9 @@ void ParaView::LoResDataPipeline::exportResult(LODData &result) const
 {
   GeometryLODData &data = static_cast<GeometryLODData&>(result);
 
-  vtkDataObject *dObj = this->filter->GetOutputDataObject(0);
-  data.geometry.TakeReference(dObj->NewInstance());
-  data.geometry->ShallowCopy(dObj);
+  // execute() builds a new dataset every time and never modifies an exported
+  // one, so it can be shared without a copy.
+  data.geometry = this->output;
 }
 
 //------------------------------------------------------------------------------
@@ -88,23 +306,7 @@ void ParaView::GeometryRenderPipeline::init(const ObjectState &,
   this->actor->SetMapper(this->mapper.Get());
 
   contextState.renderer().AddActor(this->actor.Get());
-  if (RVP){
-      vtkActorCollection* totalActors = RVP->GetRenderer()->GetActors();
-      vtkActor * pCurActor = NULL;
-       totalActors->InitTraversal();
-        do
-          {
-          pCurActor = totalActors->GetNextActor();
-
-          if (pCurActor != NULL && pCurActor->GetVisibility())
-            if(pCurActor->GetMapper() !=NULL)
-              {
-              contextState.renderer().AddActor(pCurActor);
-              }
-
-          } while (pCurActor != NULL);
-      }
-  }
+}
 
 //------------------------------------------------------------------------------
 void ParaView::GeometryRenderPipeline::update(
@@ -187,6 +389,7 @@ void ParaView::GeometryRenderPipeline::disable()
 
 //------------------------------------------------------------------------------
 ParaView::ParaView()
+  : m_surfaceCounters(std::make_shared<SurfaceCounters>())
 {
 }
 
@@ -219,6 +422,13 @@ void ParaView::setRepresentation(Representation repr)
   this->objectState<GeometryState>().representation = repr;
 }
 
+//------------------------------------------------------------------------------
+ParaView::SurfaceStatistics ParaView::surfaceStatistics() const
+{
+  std::lock_guard<std::mutex> lock(m_surfaceCounters->mutex);
+  return m_surfaceCounters->stats;
+}
+
 //------------------------------------------------------------------------------
 vvLODAsyncGLObject::ObjectState *ParaView::createObjectState() const
 {
@@ -235,10 +445,18 @@ ParaView::createDataPipeline(LevelOfDetail lod) const
       return nullptr;
 
     case LevelOfDetail::LoRes:
-      return new LoResDataPipeline;
+      {
+      LoResDataPipeline *pipeline = new LoResDataPipeline;
+      pipeline->counters = m_surfaceCounters;
+      return pipeline;
+      }
 
     case LevelOfDetail::HiRes:
-      return new HiResDataPipeline;
+      {
+      HiResDataPipeline *pipeline = new HiResDataPipeline;
+      pipeline->counters = m_surfaceCounters;
+      return pipeline;
+      }
 
     default:
       return nullptr;
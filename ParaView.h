@@ -6,11 +6,19 @@
 #include <vtkNew.h>
 #include <vtkSmartPointer.h>
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 class vtkActor;
-class vtkActorCollection;
+class vtkCellArray;
 class vtkCompositeDataGeometryFilter;
+class vtkCompositePolyDataMapper2;
 class vtkDataObject;
-class vtkPolyDataMapper;
+class vtkDataSet;
+class vtkIdList;
+class vtkPoints;
+class vtkPolyData;
 class vtkSMRenderViewProxy;
 
 
@@ -40,12 +48,68 @@ public:
     void update(const vvApplicationState &state) override {}
   };
 
+  /** Surface extraction counters, see surfaceStatistics(). */
+  struct SurfaceStatistics
+  {
+    // Blocks whose surface was reused as is, rebuilt from the previous
+    // surface topology, or extracted again:
+    unsigned long long reused{0};
+    unsigned long long remapped{0};
+    unsigned long long extracted{0};
+    // Time spent in the data pipelines:
+    double seconds{0.};
+  };
+
+  // Shared by the data pipelines and the ParaView object:
+  struct SurfaceCounters
+  {
+    std::mutex mutex;
+    SurfaceStatistics stats;
+  };
+
   // LoRes LOD: ----------------------------------------------------------------
-  // Run vtkCompositeDataGeometryFilter on the reduced dataset:
+  // Run vtkCompositeDataGeometryFilter on the reduced dataset. With
+  // mvBlockParallel enabled, the surface of each block is extracted by its own
+  // task instead, and the result is a multiblock of per-block polydata that
+  // is rendered without merging. Surfaces of blocks that did not change are
+  // reused, so they keep their GPU buffers. Unstructured blocks whose
+  // connectivity did not change (see mvReader::staticTopology()) keep their
+  // surface topology, and only gather their arrays for the new timestep.
   struct LoResDataPipeline : public Superclass::DataPipeline
   {
     vtkNew<vtkCompositeDataGeometryFilter> filter;
 
+    // The surface of a block.
+    struct Surface
+    {
+      vtkSmartPointer<vtkDataSet> block;
+      unsigned long blockMTime{0};
+      vtkSmartPointer<vtkPolyData> surface;
+
+      // Unstructured blocks only: the mesh the surface was extracted from,
+      // and the block ids of the surface's points and cells.
+      vtkSmartPointer<vtkCellArray> cells;
+      unsigned long cellsMTime{0};
+      vtkSmartPointer<vtkPoints> points;
+      unsigned long pointsMTime{0};
+      vtkSmartPointer<vtkIdList> pointIds;
+      vtkSmartPointer<vtkIdList> cellIds;
+
+      // Extract the surface of block:
+      void extract();
+      // Returns true if @a other's surface topology applies to block:
+      bool sameTopology(const Surface &other) const;
+      // Build the surface of block from @a other's surface topology:
+      void remap(const Surface &other);
+    };
+    // Per-block surfaces from the last execute(), in traversal order:
+    std::vector<Surface> surfaces;
+
+    // Not modified after execute(), so it is shared with the LODData:
+    vtkSmartPointer<vtkDataObject> output;
+
+    std::shared_ptr<SurfaceCounters> counters;
+
     // Returns the dataset to use. This is the only difference between the
     // LoRes and HiRes pipelines, so this should save some duplication.
     virtual vtkDataObject* input(const vvApplicationState &state) const;
@@ -72,9 +136,8 @@ public:
 
   struct GeometryRenderPipeline : public Superclass::RenderPipeline
   {
-    vtkNew<vtkPolyDataMapper> mapper;
+    vtkNew<vtkCompositePolyDataMapper2> mapper;
     vtkNew<vtkActor> actor;
-    vtkNew<vtkActorCollection> actors;
 
     void init(const ObjectState &objState,
               vvContextState &contextState) override;
@@ -107,6 +170,12 @@ public:
   Representation representation() const;
   void setRepresentation(Representation representation);
 
+  /**
+   * The surface extraction work of the LoRes and HiRes pipelines since the
+   * start, e.g. to compare -serialBlocks with the per-block path.
+   */
+  SurfaceStatistics surfaceStatistics() const;
+
 private: // vvAsyncGLObject virtual API:
   std::string progressLabel() const override { return "PVGeometry"; }
 
@@ -119,6 +188,9 @@ private:
   // Not implemented -- disable copy:
   ParaView(const ParaView&);
   ParaView& operator=(const ParaView&);
+
+private:
+  std::shared_ptr<SurfaceCounters> m_surfaceCounters;
 };
 
 #endif // PARAVIEW_H
@@ -0,0 +1,139 @@
+// Compares the serial vtkDataArray::GetRange metadata pass that mvReader used
+// to perform against mvRange's parallel kernel.
+//
+// Usage: mvRangeBenchmark [file.ex2] [scale] [iterations]
+//
+// The blocks of the last timestep of the file are deep-copied @a scale times
+// to emulate a larger multiblock dataset.
+
+#include "mvRange.h"
+
+#include <vtkCellData.h>
+#include <vtkCompositeDataIterator.h>
+#include <vtkDataArray.h>
+#include <vtkDataSet.h>
+#include <vtkExodusIIReader.h>
+#include <vtkFieldData.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+//------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  const char *fileName = argc > 1 ? argv[1] : "data/disk_out_ref.ex2";
+  const int scale = argc > 2 ? std::atoi(argv[2]) : 64;
+  const int iterations = argc > 3 ? std::atoi(argv[3]) : 10;
+
+  vtkNew<vtkExodusIIReader> reader;
+  reader->SetFileName(fileName);
+  reader->UpdateInformation();
+  for (int i = 0; i < reader->GetNumberOfPointResultArrays(); ++i)
+    {
+    reader->SetPointResultArrayStatus(reader->GetPointResultArrayName(i), 1);
+    }
+  for (int i = 0; i < reader->GetNumberOfElementResultArrays(); ++i)
+    {
+    reader->SetElementResultArrayStatus(reader->GetElementResultArrayName(i),
+                                        1);
+    }
+  int timeSteps[2];
+  reader->GetTimeStepRange(timeSteps);
+  reader->SetTimeStep(timeSteps[1]);
+  reader->Update();
+
+  // Scale up the dataset:
+  vtkNew<vtkMultiBlockDataSet> scaled;
+  std::vector<vtkDataArray*> arrays;
+  unsigned int block = 0;
+  for (int s = 0; s < scale; ++s)
+    {
+    vtkCompositeDataIterator *it = reader->GetOutput()->NewIterator();
+    for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+      {
+      vtkDataSet *ds = vtkDataSet::SafeDownCast(it->GetCurrentDataObject());
+      if (!ds)
+        {
+        continue;
+        }
+      vtkSmartPointer<vtkDataSet> copy;
+      copy.TakeReference(ds->NewInstance());
+      copy->DeepCopy(ds);
+      scaled->SetBlock(block++, copy);
+
+      vtkFieldData *fds[3] = { copy->GetFieldData(), copy->GetPointData(),
+                               copy->GetCellData() };
+      for (vtkFieldData *fd : fds)
+        {
+        for (int a = 0; a < fd->GetNumberOfArrays(); ++a)
+          {
+          if (vtkDataArray *array = fd->GetArray(a))
+            {
+            arrays.push_back(array);
+            }
+          }
+        }
+      }
+    it->Delete();
+    }
+
+  std::cout << "Blocks: " << block << ", arrays: " << arrays.size()
+            << ", iterations: " << iterations << std::endl;
+
+  std::vector<mvRange::Range> serial(arrays.size());
+  std::vector<mvRange::Range> parallel;
+  vtkNew<vtkTimerLog> timer;
+
+  // Serial GetRange. Modified() invalidates the range cached in the array.
+  double serialTime = 0.;
+  for (int iter = 0; iter < iterations; ++iter)
+    {
+    for (vtkDataArray *array : arrays)
+      {
+      array->Modified();
+      }
+    timer->StartTimer();
+    for (size_t a = 0; a < arrays.size(); ++a)
+      {
+      arrays[a]->GetRange(serial[a].data());
+      }
+    timer->StopTimer();
+    serialTime += timer->GetElapsedTime();
+    }
+
+  double parallelTime = 0.;
+  for (int iter = 0; iter < iterations; ++iter)
+    {
+    timer->StartTimer();
+    parallel = mvRange::compute(arrays);
+    timer->StopTimer();
+    parallelTime += timer->GetElapsedTime();
+    }
+
+  size_t mismatches = 0;
+  for (size_t a = 0; a < arrays.size(); ++a)
+    {
+    if (serial[a][0] != parallel[a][0] || serial[a][1] != parallel[a][1])
+      {
+      std::cerr << "Range mismatch for '"
+                << (arrays[a]->GetName() ? arrays[a]->GetName() : "") << "': "
+                << serial[a][0] << ", " << serial[a][1] << " (serial) vs. "
+                << parallel[a][0] << ", " << parallel[a][1] << " (mvRange)"
+                << std::endl;
+      ++mismatches;
+      }
+    }
+
+  std::cout << "Serial GetRange: " << serialTime / iterations << "s\n"
+            << "mvRange:         " << parallelTime / iterations << "s\n"
+            << "Speedup:         " << serialTime / parallelTime << "x"
+            << std::endl;
+
+  return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
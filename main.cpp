@@ -27,6 +27,41 @@ void printUsage(bool longForm = true)
     std::cout << "\tShow the FPS display by default.\n" << std::endl;
     std::cout << "\t-benchmark" << std::endl;
     std::cout << "\tPrints timing information for data updates to stderr.\n" << std::endl;
+    std::cout << "\t-prefetch <digit>" << std::endl;
+    std::cout << "\tNumber of timesteps to read ahead in the background.\n" << std::endl;
+    std::cout << "\t-prefetchBehind <digit>" << std::endl;
+    std::cout << "\tNumber of previous timesteps to keep in memory.\n" << std::endl;
+    std::cout << "\t-cacheBudget <digit>" << std::endl;
+    std::cout << "\tMemory budget in MiB for cached timestep data (default 1024).\n" << std::endl;
+    std::cout << "\t-imageCacheBudget <digit>" << std::endl;
+    std::cout << "\tMemory budget in MiB for cached resampled volumes (default 512).\n" << std::endl;
+    std::cout << "\t-globalRange" << std::endl;
+    std::cout << "\tColor by the range of the whole time series. Computed in the\n"
+                 "\tbackground once and cached next to the file.\n" << std::endl;
+    std::cout << "\t-histogramBins <digit>" << std::endl;
+    std::cout << "\tNumber of histogram bins computed per variable (default 256).\n" << std::endl;
+    std::cout << "\t-histogramLog" << std::endl;
+    std::cout << "\tDisplay histograms on a logarithmic scale.\n" << std::endl;
+    std::cout << "\t-loResVoxels <digit>" << std::endl;
+    std::cout << "\tSample the LoRes preview with about this many voxels, following\n"
+                 "\tthe aspect ratio of the data (default: fixed 64^3 grid).\n" << std::endl;
+    std::cout << "\t-loResTime <float>" << std::endl;
+    std::cout << "\tTime budget in seconds for LoRes resampling with -loResVoxels\n"
+                 "\t(default 0.25, 0 disables).\n" << std::endl;
+    std::cout << "\t-serialBlocks" << std::endl;
+    std::cout << "\tProcess the blocks of the dataset one at a time instead of\n"
+                 "\tconcurrently.\n" << std::endl;
+    std::cout << "\t-orthoSlices" << std::endl;
+    std::cout << "\tSlice along the X, Y and Z axes at once. The interactor moves\n"
+                 "\tthe first plane.\n" << std::endl;
+    std::cout << "\t-connectTimeout <float>" << std::endl;
+    std::cout << "\tSeconds to wait for the ParaView server before rendering only the\n"
+                 "\tlocal dataset (default 5). The connection is retried in the\n"
+                 "\tbackground.\n" << std::endl;
+    std::cout << "\t-noRemoteLOD" << std::endl;
+    std::cout << "\tRequest only full-resolution geometry from the ParaView server,\n"
+                 "\tinstead of its decimated LOD geometry first. The server only\n"
+                 "\tdecimates geometry above the render view's LOD threshold.\n" << std::endl;
     std::cout << "\t-hidebgnotifs" << std::endl;
     std::cout << "\tHide notifications for background updates.\n" << std::endl;
     std::cout << "\t-widgetHints <path>" << std::endl;
@@ -60,6 +95,19 @@ int main(int argc, char* argv[])
     bool showFPS = false;
     bool benchmark = false;
     bool hidebgnotifs = false;
+    int prefetchAhead = 0;
+    int prefetchBehind = 0;
+    int cacheBudget = -1;
+    int imageCacheBudget = -1;
+    bool globalRange = false;
+    int histogramBins = 256;
+    bool histogramLog = false;
+    long long loResVoxels = 0;
+    double loResTime = 0.25;
+    bool blockParallel = true;
+    bool orthoSlices = false;
+    double connectTimeout = 5.;
+    bool remoteLOD = true;
     std::string widgetHints;
 
     vtkNew<vtkPVOptions> Options;
@@ -88,6 +136,66 @@ int main(int argc, char* argv[])
           {
           benchmark = true;
           }
+        if(strcmp(argv[i], "-prefetch")==0)
+          {
+          prefetchAhead = atoi(argv[i+1]);
+          ++i;
+          }
+        if(strcmp(argv[i], "-prefetchBehind")==0)
+          {
+          prefetchBehind = atoi(argv[i+1]);
+          ++i;
+          }
+        if(strcmp(argv[i], "-cacheBudget")==0)
+          {
+          cacheBudget = atoi(argv[i+1]);
+          ++i;
+          }
+        if(strcmp(argv[i], "-imageCacheBudget")==0)
+          {
+          imageCacheBudget = atoi(argv[i+1]);
+          ++i;
+          }
+        if(strcmp(argv[i], "-globalRange")==0)
+          {
+          globalRange = true;
+          }
+        if(strcmp(argv[i], "-histogramBins")==0)
+          {
+          histogramBins = atoi(argv[i+1]);
+          ++i;
+          }
+        if(strcmp(argv[i], "-histogramLog")==0)
+          {
+          histogramLog = true;
+          }
+        if(strcmp(argv[i], "-loResVoxels")==0)
+          {
+          loResVoxels = atoll(argv[i+1]);
+          ++i;
+          }
+        if(strcmp(argv[i], "-loResTime")==0)
+          {
+          loResTime = atof(argv[i+1]);
+          ++i;
+          }
+        if(strcmp(argv[i], "-serialBlocks")==0)
+          {
+          blockParallel = false;
+          }
+        if(strcmp(argv[i], "-orthoSlices")==0)
+          {
+          orthoSlices = true;
+          }
+        if(strcmp(argv[i], "-connectTimeout")==0)
+          {
+          connectTimeout = atof(argv[i+1]);
+          ++i;
+          }
+        if(strcmp(argv[i], "-noRemoteLOD")==0)
+          {
+          remoteLOD = false;
+          }
         if(strcmp(argv[i], "-hidebgnotifs")==0)
           {
           hidebgnotifs = true;
@@ -121,6 +229,22 @@ int main(int argc, char* argv[])
     application.setShowFPS(showFPS);
     application.setBenchmark(benchmark);
     application.setProgressVisibility(!hidebgnotifs);
+    application.setPrefetchWindow(prefetchAhead, prefetchBehind);
+    if(cacheBudget >= 0)
+      {
+      application.setCacheBudget(static_cast<size_t>(cacheBudget) * 1024 * 1024);
+      }
+    if(imageCacheBudget >= 0)
+      {
+      application.setImageCacheBudget(static_cast<size_t>(imageCacheBudget) * 1024 * 1024);
+      }
+    application.setUseGlobalRanges(globalRange);
+    application.setHistogramOptions(histogramBins, histogramLog);
+    application.setLoResBudget(loResVoxels, loResTime);
+    application.setBlockParallel(blockParallel);
+    application.setOrthogonalSlices(orthoSlices);
+    application.setConnectTimeout(connectTimeout);
+    application.setRemoteLOD(remoteLOD);
     application.setWidgetHintsFile(widgetHints);
     if(!name.empty())
       {
@@ -132,7 +256,12 @@ int main(int argc, char* argv[])
       }
     application.initialize();
     application.run();
-    vtkInitializationHelper::Finalize();
+    // A connection attempt that is still pending uses the ServerManager, so
+    // it is left to the process exit instead:
+    if (application.disconnectParaView())
+      {
+      vtkInitializationHelper::Finalize();
+      }
     Options->Delete();
 
     return 0;
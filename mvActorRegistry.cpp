@@ -0,0 +1,233 @@
+#include "mvActorRegistry.h"
+
+#include <vtkActor.h>
+#include <vtkActorCollection.h>
+#include <vtkDataObject.h>
+#include <vtkMapper.h>
+#include <vtkProperty.h>
+#include <vtkPVLODActor.h>
+#include <vtkRenderer.h>
+#include <vtkScalarsToColors.h>
+
+#include <set>
+
+namespace {
+
+// The mapper that @a actor draws. ParaView's LOD actors draw their LOD mapper
+// while the decimated geometry is delivered:
+vtkMapper* drawnMapper(vtkActor *actor)
+{
+  vtkPVLODActor *lodActor = vtkPVLODActor::SafeDownCast(actor);
+  if (lodActor && lodActor->GetEnableLOD() && lodActor->GetLODMapper())
+    {
+    return lodActor->GetLODMapper();
+    }
+  return actor->GetMapper();
+}
+
+} // end anon namespace
+
+//------------------------------------------------------------------------------
+bool mvActorRegistry::Entry::refresh()
+{
+  vtkMapper *newMapper = drawnMapper(this->actor);
+  vtkDataObject *newData = newMapper ? newMapper->GetInputDataObject(0, 0)
+                                     : nullptr;
+  const unsigned long newActorMTime = this->actor->GetMTime();
+  const unsigned long newMapperMTime = newMapper ? newMapper->GetMTime() : 0;
+  const unsigned long newDataMTime = newData ? newData->GetMTime() : 0;
+
+  const bool changed = newMapper != this->mapper ||
+                       newData != this->data ||
+                       newActorMTime != this->actorMTime ||
+                       newMapperMTime != this->mapperMTime ||
+                       newDataMTime != this->dataMTime;
+
+  this->mapper = newMapper;
+  this->data = newData;
+  this->actorMTime = newActorMTime;
+  this->mapperMTime = newMapperMTime;
+  this->dataMTime = newDataMTime;
+  return changed;
+}
+
+//------------------------------------------------------------------------------
+void mvActorRegistry::Entry::copy()
+{
+  if (!this->local)
+    {
+    this->local = vtkSmartPointer<vtkActor>::New();
+    this->localProperty = vtkSmartPointer<vtkProperty>::New();
+    this->local->SetProperty(this->localProperty);
+    }
+
+  // Placement and visibility, without the property and mapper, which
+  // vtkActor::ShallowCopy() would share:
+  this->local->vtkProp3D::ShallowCopy(this->actor);
+  this->localProperty->DeepCopy(this->actor->GetProperty());
+  this->local->SetTexture(this->actor->GetTexture());
+
+  // The mapper is kept while its type is, so that the GPU buffers of the
+  // unchanged blocks are kept too:
+  if (!this->localMapper ||
+      !this->localMapper->IsA(this->mapper->GetClassName()))
+    {
+    this->localMapper.TakeReference(this->mapper->NewInstance());
+    this->local->SetMapper(this->localMapper);
+    }
+  this->localMapper->ShallowCopy(this->mapper);
+
+  vtkScalarsToColors *colors = this->mapper->GetLookupTable();
+  if (colors)
+    {
+    if (!this->localColors || !this->localColors->IsA(colors->GetClassName()))
+      {
+      this->localColors.TakeReference(colors->NewInstance());
+      }
+    this->localColors->DeepCopy(colors);
+    }
+  this->localMapper->SetLookupTable(colors ? this->localColors.Get()
+                                           : nullptr);
+
+  // Shallow, the sync thread replaces the delivered data rather than
+  // modifying it:
+  vtkSmartPointer<vtkDataObject> data;
+  if (this->data)
+    {
+    data.TakeReference(this->data->NewInstance());
+    data->ShallowCopy(this->data);
+    }
+  this->localMapper->SetInputDataObject(0, data);
+}
+
+//------------------------------------------------------------------------------
+mvActorRegistry::mvActorRegistry()
+{
+}
+
+//------------------------------------------------------------------------------
+mvActorRegistry::~mvActorRegistry()
+{
+}
+
+//------------------------------------------------------------------------------
+mvActorRegistry::Stats mvActorRegistry::sync(vtkRenderer *source,
+                                             vtkRenderer &target)
+{
+  Stats stats;
+  std::map<vtkActor*, Entry> &installed = this->installed(target);
+
+  std::set<vtkActor*> current;
+  if (source)
+    {
+    vtkActorCollection *actors = source->GetActors();
+    vtkCollectionSimpleIterator it;
+    actors->InitTraversal(it);
+    while (vtkActor *actor = actors->GetNextActor(it))
+      {
+      if (actor->GetVisibility() && actor->GetMapper())
+        {
+        current.insert(actor);
+        }
+      }
+    }
+
+  // Remove the actors that are gone or hidden:
+  for (auto it = installed.begin(); it != installed.end();)
+    {
+    if (current.count(it->first) == 0)
+      {
+      target.RemoveActor(it->second.local);
+      it = installed.erase(it);
+      ++stats.removed;
+      }
+    else
+      {
+      ++it;
+      }
+    }
+
+  // Add the new actors, and refresh the ones that changed:
+  for (vtkActor *actor : current)
+    {
+    auto it = installed.find(actor);
+    const bool added = it == installed.end();
+    if (added)
+      {
+      it = installed.insert(std::make_pair(actor, Entry())).first;
+      it->second.actor = actor;
+      }
+
+    if (it->second.refresh())
+      {
+      drawnMapper(actor)->UpdateDataObject();
+      // UpdateDataObject() may replace the mapper's input:
+      it->second.refresh();
+      it->second.copy();
+      if (!added)
+        {
+        ++stats.updated;
+        }
+      }
+
+    if (added)
+      {
+      target.AddActor(it->second.local);
+      ++stats.added;
+      }
+    }
+
+  return stats;
+}
+
+//------------------------------------------------------------------------------
+void mvActorRegistry::clear(vtkRenderer &target)
+{
+  auto it = m_targets.find(&target);
+  if (it == m_targets.end())
+    {
+    return;
+    }
+
+  if (it->second.renderer)
+    {
+    for (const auto &installed : it->second.installed)
+      {
+      target.RemoveActor(installed.second.local);
+      }
+    }
+  m_targets.erase(it);
+}
+
+//------------------------------------------------------------------------------
+bool mvActorRegistry::empty(vtkRenderer &target) const
+{
+  auto it = m_targets.find(&target);
+  return it == m_targets.end() || !it->second.renderer ||
+      it->second.installed.empty();
+}
+
+//------------------------------------------------------------------------------
+std::map<vtkActor*, mvActorRegistry::Entry>&
+mvActorRegistry::installed(vtkRenderer &target)
+{
+  // Forget the renderers of destroyed contexts:
+  for (auto it = m_targets.begin(); it != m_targets.end();)
+    {
+    if (!it->second.renderer)
+      {
+      it = m_targets.erase(it);
+      }
+    else
+      {
+      ++it;
+      }
+    }
+
+  Target &entry = m_targets[&target];
+  if (!entry.renderer)
+    {
+    entry.renderer = &target;
+    }
+  return entry.installed;
+}
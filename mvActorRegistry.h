@@ -0,0 +1,106 @@
+#ifndef MVACTORREGISTRY_H
+#define MVACTORREGISTRY_H
+
+#include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
+
+#include <map>
+
+class vtkActor;
+class vtkDataObject;
+class vtkMapper;
+class vtkProperty;
+class vtkRenderer;
+class vtkScalarsToColors;
+
+/**
+ * @brief The mvActorRegistry class mirrors the actors of a remote render view
+ * into local renderers.
+ *
+ * The registry remembers which actors it installed in each target renderer,
+ * keyed by actor. Each GL context has a renderer of its own, so one registry
+ * serves all contexts. sync() diffs the visible, mapped actors of the source
+ * renderer against the ones installed in the target: new
+ * actors are added, vanished or hidden ones are removed, and only the actors
+ * whose actor, mapper or mapped data changed are refreshed. Actors that other
+ * objects put in the local renderer are left alone.
+ *
+ * The target draws copies: the remote actors, their mappers and the
+ * delivered data are replaced by the ParaView sync thread while the target
+ * is drawn. A copy shares the delivered arrays, and keeps showing them until
+ * the next sync, e.g. the decimated LOD geometry until the full resolution
+ * has arrived. The registry is not locked, the source renderer is shared
+ * with the ParaView sync thread, so call it with the ParaView sync mutex
+ * held.
+ */
+class mvActorRegistry
+{
+public:
+  /** What a sync() changed. */
+  struct Stats
+  {
+    int added{0};
+    int removed{0};
+    int updated{0};
+
+    bool changed() const
+    {
+      return this->added != 0 || this->removed != 0 || this->updated != 0;
+    }
+  };
+
+  mvActorRegistry();
+  ~mvActorRegistry();
+
+  /** Make @a target show the visible, mapped actors of @a source. */
+  Stats sync(vtkRenderer *source, vtkRenderer &target);
+
+  /** Remove the actors installed in @a target from it. */
+  void clear(vtkRenderer &target);
+
+  /** True if no actors are installed in @a target. */
+  bool empty(vtkRenderer &target) const;
+
+private:
+  struct Entry
+  {
+    // Holds the key, so that its address is not reused while installed:
+    vtkSmartPointer<vtkActor> actor;
+    // The copy of actor that is drawn, see copy():
+    vtkSmartPointer<vtkActor> local;
+    vtkSmartPointer<vtkMapper> localMapper;
+    vtkSmartPointer<vtkProperty> localProperty;
+    vtkSmartPointer<vtkScalarsToColors> localColors;
+    unsigned long actorMTime{0};
+    vtkMapper *mapper{nullptr};
+    unsigned long mapperMTime{0};
+    vtkDataObject *data{nullptr};
+    unsigned long dataMTime{0};
+
+    // Record the current state of actor. Returns true if it changed.
+    bool refresh();
+    // Copy the recorded state of actor into local:
+    void copy();
+  };
+
+  struct Target
+  {
+    // Detects a renderer that was destroyed, and whose address is reused
+    // by the renderer of a new context:
+    vtkWeakPointer<vtkRenderer> renderer;
+    std::map<vtkActor*, Entry> installed;
+  };
+
+  // The installed actors of @a target, reset if it is a new renderer:
+  std::map<vtkActor*, Entry>& installed(vtkRenderer &target);
+
+private:
+  // Not implemented -- disable copy:
+  mvActorRegistry(const mvActorRegistry&);
+  mvActorRegistry& operator=(const mvActorRegistry&);
+
+private:
+  std::map<vtkRenderer*, Target> m_targets;
+};
+
+#endif // MVACTORREGISTRY_H
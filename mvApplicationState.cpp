@@ -7,6 +7,7 @@
 #include "ParaView.h"
 #include "mvInteractor.h"
 #include "mvOutline.h"
+#include "mvParaViewSync.h"
 #include "mvSlice.h"
 #include "mvReader.h"
 #include "mvVolume.h"
@@ -22,6 +23,7 @@ mvApplicationState::mvApplicationState()
     m_paraview(new ParaView),
     m_interactor(new mvInteractor),
     m_outline(new mvOutline),
+    m_paraViewSync(new mvParaViewSync),
     m_reader(new mvReader),
     m_widgetHints(new WidgetHints()),
     m_slice(new mvSlice()),
@@ -42,6 +44,7 @@ mvApplicationState::~mvApplicationState()
   delete m_geometry;
   delete m_interactor;
   delete m_outline;
+  delete m_paraViewSync;
   delete m_reader;
   delete m_slice;
   delete m_volume;
@@ -13,6 +13,7 @@ class mvGeometry;
 class ParaView;
 class mvInteractor;
 class mvOutline;
+class mvParaViewSync;
 class mvReader;
 class mvSlice;
 class mvVolume;
@@ -65,6 +66,10 @@ public:
   mvOutline& outline() { return *m_outline; }
   const mvOutline& outline() const { return *m_outline; }
 
+  /** Follows the remote ParaView session.
+   * Access is not const-correct because the ServerManager is not. */
+  mvParaViewSync& paraViewSync() const { return *m_paraViewSync; }
+
   /** File reader.
    * Access is not const-correct because VTK is not const-correct. */
   mvReader& reader() const { return *m_reader; }
@@ -94,6 +99,7 @@ private:
   ParaView *m_paraview;
   mvInteractor *m_interactor;
   mvOutline *m_outline;
+  mvParaViewSync *m_paraViewSync;
   mvReader *m_reader;
   mvSlice *m_slice;
   mvVolume *m_volume;
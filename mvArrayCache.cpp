@@ -0,0 +1,304 @@
+#include "mvArrayCache.h"
+
+#include <vtkAbstractArray.h>
+#include <vtkCellData.h>
+#include <vtkCompositeDataIterator.h>
+#include <vtkDataObject.h>
+#include <vtkDataSet.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkPointData.h>
+
+#include <cassert>
+
+namespace {
+
+// ShallowCopy() of a composite dataset shares its leaves. Replaces the leaf at
+// @a it with a shallow copy of its own, so that its arrays can be changed
+// without affecting the other owners of the leaf.
+vtkDataSet* detachLeaf(vtkMultiBlockDataSet *data, vtkCompositeDataIterator *it)
+{
+  vtkDataSet *leaf = vtkDataSet::SafeDownCast(it->GetCurrentDataObject());
+  if (!leaf)
+    {
+    return nullptr;
+    }
+
+  vtkDataSet *copy = leaf->NewInstance();
+  copy->ShallowCopy(leaf);
+  data->SetDataSet(it, copy);
+  copy->FastDelete();
+  return copy;
+}
+
+} // end anon namespace
+
+//------------------------------------------------------------------------------
+mvArrayCache::mvArrayCache()
+  : m_budget(static_cast<size_t>(1024) * 1024 * 1024)
+{
+}
+
+//------------------------------------------------------------------------------
+mvArrayCache::~mvArrayCache()
+{
+}
+
+//------------------------------------------------------------------------------
+size_t mvArrayCache::budget() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_budget;
+}
+
+//------------------------------------------------------------------------------
+void mvArrayCache::setBudget(size_t bytes)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_budget = bytes;
+  this->evict();
+}
+
+//------------------------------------------------------------------------------
+void mvArrayCache::clear()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_entries.clear();
+  m_lru.clear();
+  m_stats.bytes = 0;
+  m_stats.entries = 0;
+}
+
+//------------------------------------------------------------------------------
+void mvArrayCache::store(int meshKey, int timeStep, vtkMultiBlockDataSet *data,
+                         const Variables &variables)
+{
+  if (!data)
+    {
+    return;
+    }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  // Mesh: Strip the variables from a shallow copy of the dataset. The leaves
+  // are still used by the caller, so they are copied as well.
+  Key meshK(meshKey, std::string());
+  if (!this->find(meshK))
+    {
+    Entry entry;
+    entry.mesh.TakeReference(data->NewInstance());
+    entry.mesh->ShallowCopy(data);
+
+    vtkCompositeDataIterator *it = entry.mesh->NewIterator();
+    for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+      {
+      if (vtkDataSet *ds = detachLeaf(entry.mesh, it))
+        {
+        for (const auto &var : variables)
+          {
+          ds->GetPointData()->RemoveArray(var.c_str());
+          ds->GetCellData()->RemoveArray(var.c_str());
+          }
+        }
+      }
+    it->Delete();
+
+    entry.bytes = static_cast<size_t>(entry.mesh->GetActualMemorySize()) * 1024;
+    this->insert(meshK, entry);
+    }
+
+  // Variables:
+  for (const auto &var : variables)
+    {
+    Key key(timeStep, var);
+    if (this->find(key))
+      {
+      continue;
+      }
+
+    Entry entry;
+    bool found = false;
+    vtkCompositeDataIterator *it = data->NewIterator();
+    for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+      {
+      vtkAbstractArray *array = nullptr;
+      if (vtkDataSet *ds = vtkDataSet::SafeDownCast(it->GetCurrentDataObject()))
+        {
+        if ((array = ds->GetPointData()->GetAbstractArray(var.c_str())))
+          {
+          entry.association = vtkDataObject::FIELD_ASSOCIATION_POINTS;
+          }
+        else if ((array = ds->GetCellData()->GetAbstractArray(var.c_str())))
+          {
+          entry.association = vtkDataObject::FIELD_ASSOCIATION_CELLS;
+          }
+        }
+
+      if (array)
+        {
+        found = true;
+        entry.bytes += static_cast<size_t>(array->GetActualMemorySize()) * 1024;
+        }
+      entry.arrays.push_back(array);
+      }
+    it->Delete();
+
+    if (found)
+      {
+      this->insert(key, entry);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+vtkSmartPointer<vtkMultiBlockDataSet>
+mvArrayCache::assemble(int meshKey, int timeStep, const Variables &variables)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  Entry *meshEntry = this->find(Key(meshKey, std::string()));
+  if (!meshEntry)
+    {
+    ++m_stats.misses;
+    return nullptr;
+    }
+
+  std::vector<const Entry*> arrays;
+  for (const auto &var : variables)
+    {
+    Entry *entry = this->find(Key(timeStep, var));
+    if (!entry)
+      {
+      ++m_stats.misses;
+      return nullptr;
+      }
+    arrays.push_back(entry);
+    }
+
+  // The cached mesh leaves are shared by all timesteps, and may be in use by
+  // a previous result. Add the arrays to copies of them:
+  vtkSmartPointer<vtkMultiBlockDataSet> result;
+  result.TakeReference(meshEntry->mesh->NewInstance());
+  result->ShallowCopy(meshEntry->mesh);
+
+  size_t leaf = 0;
+  bool valid = true;
+  vtkCompositeDataIterator *it = result->NewIterator();
+  for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+    {
+    vtkDataSet *ds = detachLeaf(result, it);
+    for (const Entry *entry : arrays)
+      {
+      if (leaf >= entry->arrays.size())
+        { // Dataset structure changed, shouldn't happen.
+        valid = false;
+        break;
+        }
+      vtkAbstractArray *array = entry->arrays[leaf].Get();
+      if (!ds || !array)
+        {
+        continue;
+        }
+      if (entry->association == vtkDataObject::FIELD_ASSOCIATION_POINTS)
+        {
+        ds->GetPointData()->AddArray(array);
+        }
+      else
+        {
+        ds->GetCellData()->AddArray(array);
+        }
+      }
+    if (!valid)
+      {
+      break;
+      }
+    ++leaf;
+    }
+  it->Delete();
+
+  if (!valid)
+    {
+    ++m_stats.misses;
+    return nullptr;
+    }
+
+  ++m_stats.hits;
+  return result;
+}
+
+//------------------------------------------------------------------------------
+mvArrayCache::Variables mvArrayCache::missing(int meshKey, int timeStep,
+                                              const Variables &variables) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (m_entries.find(Key(meshKey, std::string())) == m_entries.end())
+    {
+    return variables;
+    }
+
+  Variables result;
+  for (const auto &var : variables)
+    {
+    if (m_entries.find(Key(timeStep, var)) == m_entries.end())
+      {
+      result.insert(var);
+      }
+    }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+mvArrayCache::Statistics mvArrayCache::statistics() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stats;
+}
+
+//------------------------------------------------------------------------------
+mvArrayCache::Entry *mvArrayCache::find(const Key &key)
+{
+  auto it = m_entries.find(key);
+  if (it == m_entries.end())
+    {
+    return nullptr;
+    }
+
+  // Mark as most recently used:
+  m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+  return &it->second;
+}
+
+//------------------------------------------------------------------------------
+void mvArrayCache::insert(const Key &key, Entry &entry)
+{
+  assert(m_entries.find(key) == m_entries.end());
+
+  // Don't bother with entries that can never fit:
+  if (entry.bytes > m_budget)
+    {
+    return;
+    }
+
+  m_lru.push_front(key);
+  entry.lru = m_lru.begin();
+  m_entries.insert(std::make_pair(key, entry));
+  m_stats.bytes += entry.bytes;
+  ++m_stats.entries;
+
+  this->evict();
+}
+
+//------------------------------------------------------------------------------
+void mvArrayCache::evict()
+{
+  while (m_stats.bytes > m_budget && !m_lru.empty())
+    {
+    auto it = m_entries.find(m_lru.back());
+    assert(it != m_entries.end());
+    m_stats.bytes -= it->second.bytes;
+    --m_stats.entries;
+    ++m_stats.evictions;
+    m_entries.erase(it);
+    m_lru.pop_back();
+    }
+}
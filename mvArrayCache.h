@@ -0,0 +1,130 @@
+#ifndef MVARRAYCACHE_H
+#define MVARRAYCACHE_H
+
+#include <vtkSmartPointer.h>
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+class vtkAbstractArray;
+class vtkMultiBlockDataSet;
+
+/**
+ * @brief The mvArrayCache class holds decoded variables for recently used
+ * timesteps under a fixed memory budget.
+ *
+ * Datasets read by mvReader are split into a mesh (the dataset with the
+ * variable arrays removed) and one entry per (timestep, variable) holding
+ * that variable's array for every leaf of the dataset. Since the mesh of an
+ * Exodus file normally does not change between timesteps, a single mesh
+ * entry is shared by all timesteps (see the meshKey arguments).
+ *
+ * Entries are evicted in least-recently-used order once budget() is
+ * exceeded. All methods are thread-safe.
+ */
+class mvArrayCache
+{
+public:
+  using Variables = std::set<std::string>;
+
+  /** Cache effectiveness counters, see statistics(). */
+  struct Statistics
+  {
+    Statistics() : hits(0), misses(0), evictions(0), bytes(0), entries(0) {}
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long evictions;
+    size_t bytes;
+    size_t entries;
+  };
+
+  mvArrayCache();
+  ~mvArrayCache();
+
+  /** The maximum number of bytes held by the cache. @{ */
+  size_t budget() const;
+  void setBudget(size_t bytes);
+  /** @} */
+
+  /** Remove all entries. The statistics are preserved. */
+  void clear();
+
+  /**
+   * Split @a data into a mesh entry (for @a meshKey) and array entries for
+   * each of @a variables at @a timeStep. Existing entries are refreshed.
+   */
+  void store(int meshKey, int timeStep, vtkMultiBlockDataSet *data,
+             const Variables &variables);
+
+  /**
+   * Build a dataset for @a timeStep with @a variables from cached entries.
+   * Returns nullptr if the mesh or any of the variables is not cached.
+   */
+  vtkSmartPointer<vtkMultiBlockDataSet> assemble(int meshKey, int timeStep,
+                                                 const Variables &variables);
+
+  /**
+   * Returns the subset of @a variables that must be read from the file to
+   * assemble() @a timeStep. If the mesh is not cached, all @a variables are
+   * returned, since reading the mesh produces them at no extra cost.
+   */
+  Variables missing(int meshKey, int timeStep,
+                    const Variables &variables) const;
+
+  /** Returns a snapshot of the hit/miss/eviction counters and memory use. */
+  Statistics statistics() const;
+
+private:
+  struct Key
+  {
+    Key(int t, const std::string &v) : timeStep(t), variable(v) {}
+    bool operator<(const Key &o) const
+    {
+      return timeStep < o.timeStep ||
+          (timeStep == o.timeStep && variable < o.variable);
+    }
+
+    int timeStep;
+    std::string variable; // Empty for mesh entries.
+  };
+
+  struct Entry
+  {
+    Entry() : association(0), bytes(0) {}
+
+    // Mesh entries:
+    vtkSmartPointer<vtkMultiBlockDataSet> mesh;
+
+    // Variable entries: One array per leaf, in iteration order. Leaves without
+    // the variable hold nullptr.
+    int association; // vtkDataObject::FieldAssociations
+    std::vector<vtkSmartPointer<vtkAbstractArray> > arrays;
+
+    size_t bytes;
+    std::list<Key>::iterator lru;
+  };
+
+  // m_mutex must be held for these:
+  Entry* find(const Key &key);
+  void insert(const Key &key, Entry &entry);
+  void evict();
+
+private:
+  // Not implemented -- disable copy:
+  mvArrayCache(const mvArrayCache&);
+  mvArrayCache& operator=(const mvArrayCache&);
+
+private:
+  mutable std::mutex m_mutex;
+  size_t m_budget;
+  std::map<Key, Entry> m_entries;
+  std::list<Key> m_lru; // Most recently used first.
+  Statistics m_stats;
+};
+
+#endif // MVARRAYCACHE_H
@@ -0,0 +1,110 @@
+#include "mvBlockParallel.h"
+
+#include <vtkCompositeDataIterator.h>
+#include <vtkCompositeDataSet.h>
+#include <vtkDataSet.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkSMPTools.h>
+
+#include <atomic>
+
+namespace {
+
+// Set on the main thread, read by the pipeline threads:
+std::atomic<bool> Enabled(true);
+
+//------------------------------------------------------------------------------
+struct TaskFunctor
+{
+  const std::function<void(size_t)> &Task;
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType i = begin; i < end; ++i)
+      {
+      this->Task(static_cast<size_t>(i));
+      }
+  }
+};
+
+} // end anon namespace
+
+//------------------------------------------------------------------------------
+bool mvBlockParallel::enabled()
+{
+  return Enabled;
+}
+
+//------------------------------------------------------------------------------
+void mvBlockParallel::setEnabled(bool enabled)
+{
+  Enabled = enabled;
+}
+
+//------------------------------------------------------------------------------
+std::vector<vtkDataSet *> mvBlockParallel::blocks(vtkDataObject *input)
+{
+  std::vector<vtkDataSet*> result;
+
+  if (vtkDataSet *ds = vtkDataSet::SafeDownCast(input))
+    {
+    result.push_back(ds);
+    }
+  else if (vtkCompositeDataSet *cds = vtkCompositeDataSet::SafeDownCast(input))
+    {
+    vtkCompositeDataIterator *it = cds->NewIterator();
+    for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+      {
+      if (vtkDataSet *leaf =
+          vtkDataSet::SafeDownCast(it->GetCurrentDataObject()))
+        {
+        result.push_back(leaf);
+        }
+      }
+    it->Delete();
+    }
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+void mvBlockParallel::forEach(size_t count,
+                              const std::function<void(size_t)> &task)
+{
+  if (!Enabled)
+    {
+    for (size_t i = 0; i < count; ++i)
+      {
+      task(i);
+      }
+    return;
+    }
+
+  // A grain of one makes every block a separate task. Blocks vary widely in
+  // size, so this lets the scheduler balance them.
+  TaskFunctor functor = { task };
+  vtkSMPTools::For(0, static_cast<vtkIdType>(count), 1, functor);
+}
+
+//------------------------------------------------------------------------------
+vtkSmartPointer<vtkMultiBlockDataSet>
+mvBlockParallel::apply(vtkDataObject *input, const BlockFunction &function)
+{
+  const std::vector<vtkDataSet*> leaves = blocks(input);
+  std::vector<vtkSmartPointer<vtkDataObject> > outputs(leaves.size());
+
+  forEach(leaves.size(), [&](size_t i)
+    {
+    outputs[i] = function(leaves[i]);
+    });
+
+  vtkSmartPointer<vtkMultiBlockDataSet> result =
+      vtkSmartPointer<vtkMultiBlockDataSet>::New();
+  result->SetNumberOfBlocks(static_cast<unsigned int>(outputs.size()));
+  for (size_t i = 0; i < outputs.size(); ++i)
+    {
+    result->SetBlock(static_cast<unsigned int>(i), outputs[i]);
+    }
+
+  return result;
+}
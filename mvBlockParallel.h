@@ -0,0 +1,58 @@
+#ifndef MVBLOCKPARALLEL_H
+#define MVBLOCKPARALLEL_H
+
+#include <vtkSmartPointer.h>
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+class vtkDataObject;
+class vtkDataSet;
+class vtkMultiBlockDataSet;
+
+/**
+ * @brief The mvBlockParallel class runs filters on the blocks of a composite
+ * dataset concurrently.
+ *
+ * Exodus files are split into element blocks, and the HiRes pipelines treat
+ * each one as an independent task. Tasks are scheduled with vtkSMPTools, one
+ * block per task, so with the TBB backend idle threads steal blocks from busy
+ * ones. The results are collected into a multiblock dataset with one block
+ * per input leaf, in traversal order, and are not merged.
+ *
+ * Each task must only use objects it owns, or that are safe to read
+ * concurrently (e.g. the input block).
+ */
+class mvBlockParallel
+{
+public:
+  using BlockFunction =
+      std::function<vtkSmartPointer<vtkDataObject>(vtkDataSet *block)>;
+
+  /**
+   * If disabled, tasks are run sequentially on the calling thread. Enabled by
+   * default. @{
+   */
+  static bool enabled();
+  static void setEnabled(bool enabled);
+  /** @} */
+
+  /** Returns the leaf datasets of @a input, or @a input if it is a dataset. */
+  static std::vector<vtkDataSet*> blocks(vtkDataObject *input);
+
+  /** Call @a task with each index in [0, @a count). */
+  static void forEach(size_t count, const std::function<void(size_t)> &task);
+
+  /**
+   * Apply @a function to each leaf of @a input. Block i of the result holds
+   * the output for leaf i, which may be nullptr.
+   */
+  static vtkSmartPointer<vtkMultiBlockDataSet> apply(
+      vtkDataObject *input, const BlockFunction &function);
+
+private:
+  mvBlockParallel(); // Not implemented.
+};
+
+#endif // MVBLOCKPARALLEL_H
@@ -0,0 +1,272 @@
+#include "mvCellLocator.h"
+
+#include <vtkBoundingBox.h>
+#include <vtkCellArray.h>
+#include <vtkIdList.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkUnstructuredGrid.h>
+
+#include "mvReader.h"
+
+#include <algorithm>
+#include <cmath>
+
+//------------------------------------------------------------------------------
+mvCellLocator::mvCellLocator()
+  : m_pointsMTime(0),
+    m_cellsMTime(0),
+    m_origin{0., 0., 0.},
+    m_spacing{1., 1., 1.},
+    m_dimensions{0, 0, 0}
+{
+}
+
+//------------------------------------------------------------------------------
+mvCellLocator::~mvCellLocator()
+{
+}
+
+//------------------------------------------------------------------------------
+void mvCellLocator::build(vtkUnstructuredGrid *grid)
+{
+  m_points = grid ? grid->GetPoints() : nullptr;
+  m_pointsMTime = m_points ? m_points->GetMTime() : 0;
+  m_cells = grid ? grid->GetCells() : nullptr;
+  m_cellsMTime = m_cells ? m_cells->GetMTime() : 0;
+  m_dimensions[0] = m_dimensions[1] = m_dimensions[2] = 0;
+  m_binOffsets.assign(1, 0);
+  m_cellIds.clear();
+  m_binBounds.clear();
+
+  if (!m_points || !m_cells)
+    {
+    return;
+    }
+
+  // Cell bounds, and the bounds of their centers:
+  const vtkIdType numCells = grid->GetNumberOfCells();
+  std::vector<double> cellBounds(6 * numCells);
+  vtkBoundingBox centers;
+  vtkNew<vtkIdList> ids;
+  for (vtkIdType cellId = 0; cellId < numCells; ++cellId)
+    {
+    double *b = &cellBounds[6 * cellId];
+    b[0] = b[2] = b[4] = VTK_DOUBLE_MAX;
+    b[1] = b[3] = b[5] = VTK_DOUBLE_MIN;
+    grid->GetCellPoints(cellId, ids.Get());
+    for (vtkIdType i = 0; i < ids->GetNumberOfIds(); ++i)
+      {
+      double p[3];
+      m_points->GetPoint(ids->GetId(i), p);
+      for (int axis = 0; axis < 3; ++axis)
+        {
+        b[2 * axis] = std::min(b[2 * axis], p[axis]);
+        b[2 * axis + 1] = std::max(b[2 * axis + 1], p[axis]);
+        }
+      }
+    if (ids->GetNumberOfIds() > 0)
+      {
+      centers.AddPoint(0.5 * (b[0] + b[1]), 0.5 * (b[2] + b[3]),
+                       0.5 * (b[4] + b[5]));
+      }
+    }
+
+  if (!centers.IsValid())
+    {
+    return;
+    }
+
+  // Grid of bins following the aspect ratio of the mesh:
+  mvReader::adaptiveDimensions(
+        centers, std::max<long long>(1, numCells / CellsPerBin), m_dimensions);
+  centers.GetMinPoint(m_origin[0], m_origin[1], m_origin[2]);
+  double lengths[3];
+  centers.GetLengths(lengths);
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    m_spacing[axis] = lengths[axis] > 0. ? lengths[axis] / m_dimensions[axis]
+                                         : 1.;
+    }
+
+  // Bin the cells by center, counting sort:
+  const vtkIdType numBins = static_cast<vtkIdType>(m_dimensions[0]) *
+      m_dimensions[1] * m_dimensions[2];
+  std::vector<vtkIdType> cellBins(numCells, -1);
+  m_binOffsets.assign(numBins + 1, 0);
+  m_binBounds.resize(6 * numBins);
+  for (vtkIdType bin = 0; bin < numBins; ++bin)
+    {
+    double *b = &m_binBounds[6 * bin];
+    b[0] = b[2] = b[4] = VTK_DOUBLE_MAX;
+    b[1] = b[3] = b[5] = VTK_DOUBLE_MIN;
+    }
+
+  for (vtkIdType cellId = 0; cellId < numCells; ++cellId)
+    {
+    const double *b = &cellBounds[6 * cellId];
+    if (b[0] > b[1])
+      { // No points.
+      continue;
+      }
+
+    int ijk[3];
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      const double center = 0.5 * (b[2 * axis] + b[2 * axis + 1]);
+      const int index = static_cast<int>(
+            std::floor((center - m_origin[axis]) / m_spacing[axis]));
+      ijk[axis] = std::max(0, std::min(index, m_dimensions[axis] - 1));
+      }
+    const vtkIdType bin = ijk[0] + m_dimensions[0] *
+        (ijk[1] + static_cast<vtkIdType>(m_dimensions[1]) * ijk[2]);
+    cellBins[cellId] = bin;
+    ++m_binOffsets[bin + 1];
+
+    double *binBounds = &m_binBounds[6 * bin];
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      binBounds[2 * axis] = std::min(binBounds[2 * axis], b[2 * axis]);
+      binBounds[2 * axis + 1] = std::max(binBounds[2 * axis + 1],
+                                         b[2 * axis + 1]);
+      }
+    }
+
+  for (vtkIdType bin = 0; bin < numBins; ++bin)
+    {
+    m_binOffsets[bin + 1] += m_binOffsets[bin];
+    }
+
+  m_cellIds.resize(m_binOffsets[numBins]);
+  std::vector<vtkIdType> next(m_binOffsets.begin(), m_binOffsets.end() - 1);
+  for (vtkIdType cellId = 0; cellId < numCells; ++cellId)
+    {
+    if (cellBins[cellId] >= 0)
+      {
+      m_cellIds[next[cellBins[cellId]]++] = cellId;
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+bool mvCellLocator::refit(const mvCellLocator &reference,
+                          vtkUnstructuredGrid *grid)
+{
+  vtkPoints *points = grid ? grid->GetPoints() : nullptr;
+  vtkCellArray *cells = grid ? grid->GetCells() : nullptr;
+  if (!points || !cells || !reference.m_points ||
+      cells != reference.m_cells.Get() ||
+      cells->GetMTime() != reference.m_cellsMTime ||
+      points->GetNumberOfPoints() != reference.m_points->GetNumberOfPoints())
+    {
+    return false;
+    }
+
+  m_points = points;
+  m_pointsMTime = points->GetMTime();
+  m_cells = cells;
+  m_cellsMTime = cells->GetMTime();
+  std::copy(reference.m_origin, reference.m_origin + 3, m_origin);
+  std::copy(reference.m_spacing, reference.m_spacing + 3, m_spacing);
+  std::copy(reference.m_dimensions, reference.m_dimensions + 3, m_dimensions);
+  m_binOffsets = reference.m_binOffsets;
+  m_cellIds = reference.m_cellIds;
+
+  // The cells keep their bins, which stay conservative once the bounds
+  // cover the moved cells:
+  const vtkIdType numBins = static_cast<vtkIdType>(m_binOffsets.size()) - 1;
+  m_binBounds.resize(6 * std::max<vtkIdType>(0, numBins));
+  vtkNew<vtkIdList> ids;
+  for (vtkIdType bin = 0; bin < numBins; ++bin)
+    {
+    double *b = &m_binBounds[6 * bin];
+    b[0] = b[2] = b[4] = VTK_DOUBLE_MAX;
+    b[1] = b[3] = b[5] = VTK_DOUBLE_MIN;
+    for (vtkIdType c = m_binOffsets[bin]; c < m_binOffsets[bin + 1]; ++c)
+      {
+      grid->GetCellPoints(m_cellIds[c], ids.Get());
+      for (vtkIdType i = 0; i < ids->GetNumberOfIds(); ++i)
+        {
+        double p[3];
+        points->GetPoint(ids->GetId(i), p);
+        for (int axis = 0; axis < 3; ++axis)
+          {
+          b[2 * axis] = std::min(b[2 * axis], p[axis]);
+          b[2 * axis + 1] = std::max(b[2 * axis + 1], p[axis]);
+          }
+        }
+      }
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool mvCellLocator::matches(vtkUnstructuredGrid *grid) const
+{
+  vtkPoints *points = grid ? grid->GetPoints() : nullptr;
+  vtkCellArray *cells = grid ? grid->GetCells() : nullptr;
+  return
+      points && cells &&
+      points == m_points.Get() && points->GetMTime() == m_pointsMTime &&
+      cells == m_cells.Get() && cells->GetMTime() == m_cellsMTime;
+}
+
+//------------------------------------------------------------------------------
+void mvCellLocator::findCells(const double origin[3], const double normal[3],
+                              std::vector<vtkIdType> &cells) const
+{
+  double n[3] = { normal[0], normal[1], normal[2] };
+  if (vtkMath::Normalize(n) == 0.)
+    {
+    return;
+    }
+  const double d = vtkMath::Dot(n, origin);
+
+  this->collect([&](const double b[6])
+    {
+    double s = -d;
+    double r = 0.;
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      s += n[axis] * 0.5 * (b[2 * axis] + b[2 * axis + 1]);
+      r += std::fabs(n[axis]) * 0.5 * (b[2 * axis + 1] - b[2 * axis]);
+      }
+    return s <= r && s >= -r;
+    }, cells);
+}
+
+//------------------------------------------------------------------------------
+void mvCellLocator::findCells(const double bounds[6],
+                              std::vector<vtkIdType> &cells) const
+{
+  this->collect([&](const double b[6])
+    {
+    return
+        b[0] <= bounds[1] && b[1] >= bounds[0] &&
+        b[2] <= bounds[3] && b[3] >= bounds[2] &&
+        b[4] <= bounds[5] && b[5] >= bounds[4];
+    }, cells);
+}
+
+//------------------------------------------------------------------------------
+template <typename BinTest>
+void mvCellLocator::collect(BinTest test, std::vector<vtkIdType> &cells) const
+{
+  const size_t begin = cells.size();
+  const vtkIdType numBins = static_cast<vtkIdType>(m_binOffsets.size()) - 1;
+  for (vtkIdType bin = 0; bin < numBins; ++bin)
+    {
+    const double *b = &m_binBounds[6 * bin];
+    if (m_binOffsets[bin] == m_binOffsets[bin + 1] || !test(b))
+      {
+      continue;
+      }
+    cells.insert(cells.end(), m_cellIds.begin() + m_binOffsets[bin],
+                 m_cellIds.begin() + m_binOffsets[bin + 1]);
+    }
+
+  // Keep the cells in input order, which is friendlier to the caches of the
+  // filters using them:
+  std::sort(cells.begin() + begin, cells.end());
+}
@@ -0,0 +1,93 @@
+#ifndef MVCELLLOCATOR_H
+#define MVCELLLOCATOR_H
+
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+#include <vector>
+
+class vtkCellArray;
+class vtkPoints;
+class vtkUnstructuredGrid;
+
+/**
+ * @brief The mvCellLocator class finds the cells of an unstructured grid that
+ * may intersect a plane or a box.
+ *
+ * Cells are binned by the center of their bounding box into a uniform grid
+ * with about CellsPerBin cells per bin. Each bin also records the bounds of
+ * all of its cells. Queries test these bin bounds, so the result is
+ * conservative: it contains every intersecting cell, plus some nearby cells.
+ *
+ * A locator only depends on the mesh (points and connectivity) of the grid.
+ * mvReader builds one per block and shares them across timesteps while the
+ * mesh is unchanged (see mvReader::cellLocators()). When only the points
+ * move, e.g. a displaced mesh, refit() keeps the binning and only recomputes
+ * the bin bounds. Queries are const and may run concurrently.
+ */
+class mvCellLocator
+{
+public:
+  enum { CellsPerBin = 8 };
+
+  mvCellLocator();
+  ~mvCellLocator();
+
+  /** Bin the cells of @a grid. */
+  void build(vtkUnstructuredGrid *grid);
+
+  /**
+   * Reuse the bins of @a reference for @a grid, whose cells must be the same
+   * and whose points may have moved. Only the bin bounds are recomputed.
+   * Returns false, leaving this locator unchanged, if the cells differ.
+   */
+  bool refit(const mvCellLocator &reference, vtkUnstructuredGrid *grid);
+
+  /** Returns true if this locator was built for the mesh of @a grid. */
+  bool matches(vtkUnstructuredGrid *grid) const;
+
+  /** The number of bins along each axis. */
+  const int* dimensions() const { return m_dimensions; }
+
+  /**
+   * Append the ids of the cells that may intersect the plane through
+   * @a origin along @a normal to @a cells, in increasing order.
+   */
+  void findCells(const double origin[3], const double normal[3],
+                 std::vector<vtkIdType> &cells) const;
+
+  /**
+   * Append the ids of the cells that may intersect the box @a bounds
+   * (xmin, xmax, ymin, ymax, zmin, zmax) to @a cells, in increasing order.
+   */
+  void findCells(const double bounds[6], std::vector<vtkIdType> &cells) const;
+
+private:
+  // Append the cells of the bins selected by @a test, in increasing order:
+  template <typename BinTest>
+  void collect(BinTest test, std::vector<vtkIdType> &cells) const;
+
+private:
+  // Not implemented -- disable copy:
+  mvCellLocator(const mvCellLocator&);
+  mvCellLocator& operator=(const mvCellLocator&);
+
+private:
+  // The mesh the locator was built for:
+  vtkSmartPointer<vtkPoints> m_points;
+  unsigned long m_pointsMTime;
+  vtkSmartPointer<vtkCellArray> m_cells;
+  unsigned long m_cellsMTime;
+
+  double m_origin[3];
+  double m_spacing[3];
+  int m_dimensions[3];
+
+  // The cells of bin b are m_cellIds[m_binOffsets[b], m_binOffsets[b + 1]):
+  std::vector<vtkIdType> m_binOffsets;
+  std::vector<vtkIdType> m_cellIds;
+  // Bounds of the cells in each bin, 6 per bin. Empty bins are inverted.
+  std::vector<double> m_binBounds;
+};
+
+#endif // MVCELLLOCATOR_H
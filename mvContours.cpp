@@ -4,16 +4,22 @@
 
 #include <vtkActor.h>
 #include <vtkCompositeDataGeometryFilter.h>
+#include <vtkCompositePolyDataMapper2.h>
+#include <vtkContourGrid.h>
+#include <vtkDataArray.h>
 #include <vtkExternalOpenGLRenderer.h>
 #include <vtkFlyingEdges3D.h>
 #include <vtkLookupTable.h>
 #include <vtkMultiBlockDataSet.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
 #include <vtkPolyDataMapper.h>
 #include <vtkSMPContourGrid.h>
 #include <vtkSpanSpace.h>
 #include <vtkUnstructuredGrid.h>
 
 #include "mvApplicationState.h"
+#include "mvBlockParallel.h"
 #include "vvContextState.h"
 #include "mvReader.h"
 
@@ -182,6 +188,10 @@ void mvContours::LoResRenderPipeline::disable()
 
 //------------------------------------------------------------------------------
 mvContours::HiResDataPipeline::HiResDataPipeline()
+  : sourceInput(nullptr),
+    sourceInputMTime(0),
+    inputMTime(0),
+    association(vtkDataObject::FIELD_ASSOCIATION_NONE)
 {
   this->contour->GenerateTrianglesOn();
   this->contour->ComputeScalarsOn();
@@ -190,8 +200,6 @@ mvContours::HiResDataPipeline::HiResDataPipeline()
   // bug 15969.
   this->contour->MergePiecesOff();
   this->contour->UseScalarTreeOff();
-
-  this->geometry->SetInputConnection(this->contour->GetOutputPort());
 }
 
 //------------------------------------------------------------------------------
@@ -201,49 +209,47 @@ void mvContours::HiResDataPipeline::configure(
   const mvApplicationState &appState =
       static_cast<const mvApplicationState &>(vvState);
 
-  // Only modify the filter if the colorByArray is loaded.
+  // Only contour if the colorByArray is loaded.
   auto metaData = appState.reader().variableMetaData(appState.colorByArray());
-  if (!metaData.valid())
-    {
-    this->contour->SetInputDataObject(nullptr);
-    return;
-    }
+  vtkDataObject *dObj = metaData.valid() ? appState.reader().dataObject()
+                                         : nullptr;
 
-  this->contour->SetInputDataObject(appState.reader().dataObject());
-
-  // Use the correct array for contouring:
+  int association = vtkDataObject::FIELD_ASSOCIATION_NONE;
   switch (metaData.location)
     {
     case mvReader::VariableMetaData::Location::CellData:
-      this->contour->SetInputArrayToProcess(
-            0, 0, 0, vtkDataObject::FIELD_ASSOCIATION_CELLS,
-            appState.colorByArray().c_str());
+      association = vtkDataObject::FIELD_ASSOCIATION_CELLS;
       break;
 
     case mvReader::VariableMetaData::Location::PointData:
-      this->contour->SetInputArrayToProcess(
-            0, 0, 0, vtkDataObject::FIELD_ASSOCIATION_POINTS,
-            appState.colorByArray().c_str());
-      break;
-
-    case mvReader::VariableMetaData::Location::FieldData:
-      this->contour->SetInputArrayToProcess(
-            0, 0, 0, vtkDataObject::FIELD_ASSOCIATION_NONE,
-            appState.colorByArray().c_str());
+      association = vtkDataObject::FIELD_ASSOCIATION_POINTS;
       break;
 
     default:
       break;
     }
 
-  // Set contour values:
+  // Map the contour values to the array's range:
   const ContourState &state = static_cast<const ContourState&>(objState);
   double min = metaData.range[0];
   double spread = metaData.range[1] - min;
-  this->contour->SetNumberOfContours(state.contourValues.size());
-  for (int i = 0; i < state.contourValues.size(); ++i)
+  std::vector<double> values;
+  for (size_t i = 0; i < state.contourValues.size(); ++i)
     {
-    this->contour->SetValue(i, (state.contourValues[i]/255.0) * spread + min);
+    values.push_back((state.contourValues[i]/255.0) * spread + min);
+    }
+
+  const unsigned long inputMTime = dObj ? dObj->GetMTime() : 0;
+  if (dObj != this->input.Get() || inputMTime != this->inputMTime ||
+      appState.colorByArray() != this->arrayName ||
+      association != this->association || values != this->values)
+    {
+    this->input = dObj;
+    this->inputMTime = inputMTime;
+    this->arrayName = appState.colorByArray();
+    this->association = association;
+    this->values.swap(values);
+    this->configureTime.Modified();
     }
 }
 
@@ -256,16 +262,148 @@ bool mvContours::HiResDataPipeline::needsUpdate(const ObjectState &objState,
 
   return
       state.visible &&
-      this->contour->GetInputDataObject(0, 0) &&
+      this->input &&
       (!data.contours ||
-       data.contours->GetMTime() < this->contour->GetMTime() ||
-       data.contours->GetMTime() < this->geometry->GetMTime());
+       data.contours->GetMTime() < this->configureTime.GetMTime());
 }
 
 //------------------------------------------------------------------------------
 void mvContours::HiResDataPipeline::execute()
 {
-  this->geometry->Update();
+  this->updateSource();
+
+  // Reuse the surfaces of unchanged values, extract the rest. Surfaces of
+  // values that were removed are dropped.
+  std::map<double, vtkSmartPointer<vtkDataObject> > surfaces;
+  for (double value : this->values)
+    {
+    auto it = this->surfaces.find(value);
+    surfaces[value] = it != this->surfaces.end() ? it->second
+                                                 : this->extractSurface(value);
+    }
+  this->surfaces.swap(surfaces);
+
+  this->pieces = vtkSmartPointer<vtkMultiBlockDataSet>::New();
+  this->pieces->SetNumberOfBlocks(static_cast<unsigned int>(this->values.size()));
+  for (size_t i = 0; i < this->values.size(); ++i)
+    {
+    this->pieces->SetBlock(static_cast<unsigned int>(i),
+                           this->surfaces[this->values[i]]);
+    }
+}
+
+//------------------------------------------------------------------------------
+void mvContours::HiResDataPipeline::updateSource()
+{
+  if (this->sourceInput == this->input.Get() &&
+      this->sourceInputMTime == this->inputMTime &&
+      this->sourceArray == this->arrayName)
+    {
+    return;
+    }
+
+  this->blocks.clear();
+  this->surfaces.clear();
+  this->sourceInput = this->input.Get();
+  this->sourceInputMTime = this->inputMTime;
+  this->sourceArray = this->arrayName;
+
+  if (this->association != vtkDataObject::FIELD_ASSOCIATION_POINTS)
+    {
+    return;
+    }
+
+  for (vtkDataSet *ds : mvBlockParallel::blocks(this->input))
+    {
+    IndexedBlock block;
+    block.grid = vtkUnstructuredGrid::SafeDownCast(ds);
+    this->blocks.push_back(block);
+    }
+
+  // Each block gets its own index, so they can be built concurrently:
+  mvBlockParallel::forEach(this->blocks.size(), [&](size_t i)
+    {
+    IndexedBlock &block = this->blocks[i];
+    vtkDataArray *scalars = block.grid
+        ? block.grid->GetPointData()->GetArray(this->arrayName.c_str())
+        : nullptr;
+    if (scalars)
+      {
+      block.index = vtkSmartPointer<vtkSpanSpace>::New();
+      block.index->SetDataSet(block.grid);
+      block.index->SetScalars(scalars);
+      block.index->BuildTree();
+      }
+    });
+}
+
+//------------------------------------------------------------------------------
+vtkSmartPointer<vtkDataObject>
+mvContours::HiResDataPipeline::extractSurface(double value)
+{
+  if (this->association == vtkDataObject::FIELD_ASSOCIATION_POINTS)
+    {
+    return this->extractIndexed(value);
+    }
+  return this->extractBruteForce(value);
+}
+
+//------------------------------------------------------------------------------
+vtkSmartPointer<vtkDataObject>
+mvContours::HiResDataPipeline::extractIndexed(double value)
+{
+  // Span space traversal is not thread-safe, but every block has its own
+  // index and filter:
+  std::vector<vtkSmartPointer<vtkPolyData> > outputs(this->blocks.size());
+  mvBlockParallel::forEach(this->blocks.size(), [&](size_t i)
+    {
+    const IndexedBlock &block = this->blocks[i];
+    if (!block.index)
+      {
+      return;
+      }
+
+    vtkNew<vtkContourGrid> contourBlock;
+    contourBlock->SetInputData(block.grid);
+    contourBlock->SetInputArrayToProcess(
+          0, 0, 0, vtkDataObject::FIELD_ASSOCIATION_POINTS,
+          this->arrayName.c_str());
+    contourBlock->GenerateTrianglesOn();
+    contourBlock->ComputeScalarsOn();
+    contourBlock->UseScalarTreeOn();
+    contourBlock->SetScalarTree(block.index);
+    contourBlock->SetValue(0, value);
+    contourBlock->Update();
+
+    outputs[i] = contourBlock->GetOutput();
+    });
+
+  vtkNew<vtkMultiBlockDataSet> surface;
+  surface->SetNumberOfBlocks(static_cast<unsigned int>(outputs.size()));
+  for (size_t i = 0; i < outputs.size(); ++i)
+    {
+    surface->SetBlock(static_cast<unsigned int>(i), outputs[i]);
+    }
+
+  return surface.GetPointer();
+}
+
+//------------------------------------------------------------------------------
+vtkSmartPointer<vtkDataObject>
+mvContours::HiResDataPipeline::extractBruteForce(double value)
+{
+  this->contour->SetInputDataObject(this->input);
+  this->contour->SetInputArrayToProcess(0, 0, 0, this->association,
+                                        this->arrayName.c_str());
+  this->contour->SetNumberOfContours(1);
+  this->contour->SetValue(0, value);
+  this->contour->Update();
+
+  vtkDataObject *output = this->contour->GetOutputDataObject(0);
+  vtkSmartPointer<vtkDataObject> surface;
+  surface.TakeReference(output->NewInstance());
+  surface->ShallowCopy(output);
+  return surface;
 }
 
 //------------------------------------------------------------------------------
@@ -273,9 +411,9 @@ void mvContours::HiResDataPipeline::exportResult(LODData &result) const
 {
   HiResLODData& data = static_cast<HiResLODData&>(result);
 
-  vtkDataObject *newContours = this->geometry->GetOutputDataObject(0);
-  data.contours.TakeReference(newContours->NewInstance());
-  data.contours->ShallowCopy(newContours);
+  // execute() builds a new dataset every time and never modifies an exported
+  // one, so it can be shared without a copy.
+  data.contours = this->pieces;
 }
 
 //------------------------------------------------------------------------------
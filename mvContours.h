@@ -5,16 +5,22 @@
 
 #include <vtkNew.h>
 #include <vtkSmartPointer.h>
+#include <vtkTimeStamp.h>
 
+#include <map>
+#include <string>
 #include <vector>
 
 class vtkActor;
 class vtkCompositeDataGeometryFilter;
+class vtkCompositePolyDataMapper2;
 class vtkDataObject;
 class vtkFlyingEdges3D;
+class vtkMultiBlockDataSet;
 class vtkPolyDataMapper;
 class vtkSMPContourGrid;
 class vtkSpanSpace;
+class vtkUnstructuredGrid;
 
 /**
  * @brief The mvContours class implements contouring.
@@ -76,11 +82,53 @@ public:
   };
 
   // HiRes LOD: ----------------------------------------------------------------
-  // Use vtkSMPContourGrid to cut contours from the full dataset.
+  // Cut contours from the full dataset. Each isovalue is extracted as an
+  // independent surface and cached, so editing one value in the dialog only
+  // recomputes that surface. The cache is dropped when the dataset or array
+  // changes.
+  //
+  // Point data is contoured block by block with vtkContourGrid, using a
+  // vtkSpanSpace index per block so that only the cells spanning an isovalue
+  // are visited. The index is built once per (dataset, array) on the
+  // background thread and reused while the contour values change. Blocks are
+  // indexed and contoured concurrently (see mvBlockParallel). Other arrays
+  // fall back to vtkSMPContourGrid.
+  //
+  // The result is a multiblock of the cached per-block polydata, which is
+  // rendered with a composite mapper without merging. Surfaces that did not
+  // change are the same objects across updates and keep their GPU buffers.
   struct HiResDataPipeline : public Superclass::DataPipeline
   {
+    // Fallback:
     vtkNew<vtkSMPContourGrid> contour;
-    vtkNew<vtkCompositeDataGeometryFilter> geometry;
+
+    // Span space index:
+    struct IndexedBlock
+    {
+      vtkSmartPointer<vtkUnstructuredGrid> grid;
+      vtkSmartPointer<vtkSpanSpace> index;
+    };
+    std::vector<IndexedBlock> blocks;
+
+    // Extracted surfaces, keyed by isovalue:
+    std::map<double, vtkSmartPointer<vtkDataObject> > surfaces;
+
+    // The dataset and array that blocks and surfaces were computed from:
+    vtkDataObject *sourceInput;
+    unsigned long sourceInputMTime;
+    std::string sourceArray;
+
+    // Rebuilt by every execute() and not modified afterwards, so it is shared
+    // with the LODData rather than copied:
+    vtkSmartPointer<vtkMultiBlockDataSet> pieces;
+
+    // Current configuration:
+    vtkSmartPointer<vtkDataObject> input;
+    unsigned long inputMTime;
+    std::string arrayName;
+    int association; // vtkDataObject::FieldAssociations
+    std::vector<double> values;
+    vtkTimeStamp configureTime;
 
     HiResDataPipeline();
     void configure(const ObjectState &objState,
@@ -89,6 +137,16 @@ public:
                      const LODData &result) const override;
     void execute() override;
     void exportResult(LODData &result) const override;
+
+    // Drop the cached surfaces and (re)build the span space index if the
+    // input or array changed:
+    void updateSource();
+    // Extract a single isosurface:
+    vtkSmartPointer<vtkDataObject> extractSurface(double value);
+    // Contour the point data using the index:
+    vtkSmartPointer<vtkDataObject> extractIndexed(double value);
+    // Contour using vtkSMPContourGrid:
+    vtkSmartPointer<vtkDataObject> extractBruteForce(double value);
   };
 
   struct HiResLODData : public Superclass::LODData
@@ -98,7 +156,7 @@ public:
 
   struct HiResRenderPipeline : public Superclass::RenderPipeline
   {
-    vtkNew<vtkPolyDataMapper> mapper;
+    vtkNew<vtkCompositePolyDataMapper2> mapper;
     vtkNew<vtkActor> actor;
 
     HiResRenderPipeline();
@@ -1,119 +1,28 @@
 #include "mvGeometry.h"
 
 #include <GL/GLContextData.h>
+#include <Vrui/Vrui.h>
 
-#include <vtkActor.h>
-#include <vtkCompositeDataGeometryFilter.h>
-#include <vtkExodusIIReader.h>
-#include <vtkExternalOpenGLRenderer.h>
-#include <vtkLookupTable.h>
-#include <vtkMultiBlockDataSet.h>
-#include <vtkPolyDataMapper.h>
-#include <vtkProperty.h>
-
-#include <vtkActor.h>
-#include <vtkActorCollection.h>
 #include <vtkSMRenderViewProxy.h>
-#include <vtkCompositeDataGeometryFilter.h>
-#include <vtkExodusIIReader.h>
-#include <vtkExternalOpenGLRenderer.h>
-#include <vtkLookupTable.h>
-#include <vtkMultiBlockDataSet.h>
-#include <vtkPolyDataMapper.h>
-#include <vtkProperty.h>
 #include <vtkRenderer.h>
 #include <vvContextState.h>
 
 #include "mvApplicationState.h"
-#include "mvReader.h"
+#include "mvParaViewSync.h"
 
 extern vtkSMRenderViewProxy* RVP;
 
 //------------------------------------------------------------------------------
-vtkDataObject *
-mvGeometry::LoResDataPipeline::input(const vvApplicationState &vvState) const
-{
-  const mvApplicationState &state =
-      static_cast<const mvApplicationState &>(vvState);
-
-  return state.reader().reducedDataObject();
-}
-
-//------------------------------------------------------------------------------
-void mvGeometry::LoResDataPipeline::configure(
-    const ObjectState &, const vvApplicationState &appState)
-{
-  this->filter->SetInputDataObject(this->input(appState));
-}
-
-//------------------------------------------------------------------------------
-bool mvGeometry::LoResDataPipeline::needsUpdate(const ObjectState &objState,
-                                                const LODData &result) const
-{
-  const GeometryState &state = static_cast<const GeometryState&>(objState);
-  const GeometryLODData &data = static_cast<const GeometryLODData&>(result);
-
-  return
-      state.visible &&
-      state.representation != Representation::NoGeometry &&
-      this->filter->GetInputDataObject(0, 0) &&
-      (!data.geometry ||
-       data.geometry->GetMTime() < this->filter->GetMTime());
-}
-
-//------------------------------------------------------------------------------
-void mvGeometry::LoResDataPipeline::execute()
+bool mvGeometry::GeometryDataPipeline::needsUpdate(const ObjectState &,
+                                                   const LODData &result) const
 {
-  this->filter->Update();
+  return !static_cast<const GeometryLODData&>(result).exported;
 }
 
 //------------------------------------------------------------------------------
-void mvGeometry::LoResDataPipeline::exportResult(LODData &result) const
+void mvGeometry::GeometryDataPipeline::exportResult(LODData &result) const
 {
-  GeometryLODData &data = static_cast<GeometryLODData&>(result);
-
-  vtkDataObject *dObj = this->filter->GetOutputDataObject(0);
-  data.geometry.TakeReference(dObj->NewInstance());
-  data.geometry->ShallowCopy(dObj);
-}
-
-//------------------------------------------------------------------------------
-vtkDataObject *
-mvGeometry::HiResDataPipeline::input(const vvApplicationState &vvState) const
-{
-  const mvApplicationState &state =
-      static_cast<const mvApplicationState &>(vvState);
-
-  return state.reader().dataObject();
-}
-
-//------------------------------------------------------------------------------
-void mvGeometry::GeometryRenderPipeline::init(const ObjectState &,
-                                              vvContextState &contextState)
-{
-  this->mapper->SetScalarVisibility(1);
-  this->actor->GetProperty()->SetEdgeColor(1., 1., 1.);
-  this->actor->SetMapper(this->mapper.Get());
-
-  //contextState.renderer().AddActor(this->actor.Get());
-
-  std::cout << "####################################"<<std::endl;
-  if (RVP){
-      vtkActorCollection* totalActors = RVP->GetRenderer()->GetActors();
-      vtkActor * pCurActor = NULL;
-       totalActors->InitTraversal();
-        do
-          {
-          pCurActor = totalActors->GetNextActor();
-
-          if (pCurActor != NULL && pCurActor->GetVisibility())
-            if(pCurActor->GetMapper() !=NULL)
-              {
-              contextState.renderer().AddActor(pCurActor);
-              }
-
-          } while (pCurActor != NULL);
-      }
+  static_cast<GeometryLODData&>(result).exported = true;
 }
 
 //------------------------------------------------------------------------------
@@ -121,118 +30,33 @@ void mvGeometry::GeometryRenderPipeline::update(
     const ObjectState &objState, const vvApplicationState &vvState,
     const vvContextState &contextState, const LODData &result)
 {
-    std::cout<<"*****************update **************" <<std::endl;
-    RVP->UpdateVTKObjects();
-    RVP->ResetCamera();
-    vtkActorCollection* removalActors = contextState.renderer().GetActors();
-    std::cout<<"total actors = " << removalActors->GetNumberOfItems()<<std::endl;
-
-    vtkActor *current = NULL;
-    removalActors->InitTraversal();
-    do
-      {
-      current = removalActors->GetNextActor();
-      contextState.renderer().RemoveActor(current);
-
-      } while (current != NULL);
-
-    if (RVP){
-        RVP->StillRender();
-        vtkActorCollection* totalActors = RVP->GetRenderer()->GetActors();
-        std::cout<<"total actors = " << totalActors->GetNumberOfItems()<<std::endl;
-        vtkActor * pCurActor = NULL;
-         totalActors->InitTraversal();
-          do
-            {
-            pCurActor = totalActors->GetNextActor();
-
-            if (pCurActor != NULL && pCurActor->GetVisibility())
-              if(pCurActor->GetMapper() !=NULL)
-                {
-                  pCurActor->GetMapper()->UpdateDataObject();
-                contextState.renderer().AddActor(pCurActor);
-                }
-
-            } while (pCurActor != NULL);
-        }
-#if 0
-
-    const mvApplicationState &appState =
-      static_cast<const mvApplicationState &>(vvState);
-  const GeometryState &state = static_cast<const GeometryState&>(objState);
-  const GeometryLODData &data = static_cast<const GeometryLODData&>(result);
-  if (!state.visible ||
-      state.representation == Representation::NoGeometry ||
-      !data.geometry)
+  // The proxies are shared with the ParaView sync thread, which also resets
+  // RVP while the session is down. Don't stall the frame while it is reading
+  // from the server, the actors are synced on a later frame:
+  std::unique_lock<std::mutex> pvLock(
+        static_cast<const mvApplicationState &>(vvState).paraViewSync()
+        .mutex(), std::try_to_lock);
+  if (!pvLock.owns_lock())
     {
-    this->disable();
-    return;
+    Vrui::requestUpdate();
     }
-
-  this->mapper->SetInputDataObject(data.geometry.Get());
-
-  auto metaData = appState.reader().variableMetaData(appState.colorByArray());
-  if (metaData.valid())
+  else if (!RVP)
     {
-    switch (metaData.location)
-    {
-    case mvReader::VariableMetaData::Location::PointData:
-      this->mapper->SetScalarModeToUsePointFieldData();
-      break;
-
-    case mvReader::VariableMetaData::Location::CellData:
-      this->mapper->SetScalarModeToUseCellFieldData();
-      break;
-
-    case mvReader::VariableMetaData::Location::FieldData:
-      this->mapper->SetScalarModeToUseFieldData();
-      break;
-
-    default:
-      break;
-    }
-
-    this->mapper->SelectColorArray(appState.colorByArray().c_str());
-    this->mapper->SetScalarRange(metaData.range);
-    this->mapper->SetLookupTable(&appState.colorMap());
+    // Local-only: drop the actors of a lost session.
+    this->remoteActors->clear(contextState.renderer());
     }
-
-  switch (state.representation)
+  else
     {
-    case mvGeometry::NoGeometry:
-      // Shouldn't happen, we check for this earlier.
-      break;
-    case mvGeometry::Points:
-      this->actor->GetProperty()->SetRepresentation(VTK_POINTS);
-      this->actor->GetProperty()->EdgeVisibilityOff();
-      break;
-    case mvGeometry::Wireframe:
-      this->actor->GetProperty()->SetRepresentation(VTK_WIREFRAME);
-      this->actor->GetProperty()->EdgeVisibilityOff();
-      break;
-    case mvGeometry::Surface:
-      this->actor->GetProperty()->SetRepresentation(VTK_SURFACE);
-      this->actor->GetProperty()->EdgeVisibilityOff();
-      break;
-    case mvGeometry::SurfaceWithEdges:
-      this->actor->GetProperty()->SetRepresentation(VTK_SURFACE);
-      this->actor->GetProperty()->EdgeVisibilityOn();
-      break;
+    // The ParaView sync thread delivered the geometry that changed. The
+    // camera of the remote view is shared with the other clients, so it is
+    // left alone:
+    this->remoteActors->sync(RVP->GetRenderer(), contextState.renderer());
     }
-
-  this->actor->GetProperty()->SetOpacity(state.opacity);
-  this->actor->SetVisibility(1);
-#endif
-}
-
-//------------------------------------------------------------------------------
-void mvGeometry::GeometryRenderPipeline::disable()
-{
-  this->actor->SetVisibility(0);
 }
 
 //------------------------------------------------------------------------------
 mvGeometry::mvGeometry()
+  : m_remoteActors(std::make_shared<mvActorRegistry>())
 {
 }
 
@@ -281,10 +105,8 @@ mvGeometry::createDataPipeline(LevelOfDetail lod) const
       return nullptr;
 
     case LevelOfDetail::LoRes:
-      return new LoResDataPipeline;
-
     case LevelOfDetail::HiRes:
-      return new HiResDataPipeline;
+      return new GeometryDataPipeline;
 
     default:
       return nullptr;
@@ -302,7 +124,11 @@ mvGeometry::createRenderPipeline(LevelOfDetail lod) const
 
     case LevelOfDetail::LoRes:
     case LevelOfDetail::HiRes:
-      return new GeometryRenderPipeline;
+      {
+      GeometryRenderPipeline *pipeline = new GeometryRenderPipeline;
+      pipeline->remoteActors = m_remoteActors;
+      return pipeline;
+      }
 
     default:
       return nullptr;
@@ -3,16 +3,17 @@
 
 #include "vvLODAsyncGLObject.h"
 
-#include <vtkNew.h>
-#include <vtkSmartPointer.h>
+#include "mvActorRegistry.h"
 
-class vtkActor;
-class vtkCompositeDataGeometryFilter;
-class vtkDataObject;
-class vtkPolyDataMapper;
+#include <memory>
 
 /**
  * @brief The mvGeometry class renders the dataset as polydata.
+ *
+ * The geometry that is shown comes from the ParaView session, see ParaView
+ * for the local per-block surfaces. No local geometry is extracted: the data
+ * pipelines produce an empty result once, so that the render pipelines run
+ * and mirror the actors of the remote render view.
  */
 class mvGeometry : public vvLODAsyncGLObject
 {
@@ -37,48 +38,38 @@ public:
     void update(const vvApplicationState &state) override {}
   };
 
-  // LoRes LOD: ----------------------------------------------------------------
-  // Run vtkCompositeDataGeometryFilter on the reduced dataset:
-  struct LoResDataPipeline : public Superclass::DataPipeline
+  // Shared: everything is shared between LoRes and HiRes. --------------------
+  // Nothing is read from the local datasets, see the class documentation:
+  struct GeometryDataPipeline : public Superclass::DataPipeline
   {
-    vtkNew<vtkCompositeDataGeometryFilter> filter;
-
-    // Returns the dataset to use. This is the only difference between the
-    // LoRes and HiRes pipelines, so this should save some duplication.
-    virtual vtkDataObject* input(const vvApplicationState &state) const;
-
-    void configure(const ObjectState &, const vvApplicationState &) override;
+    void configure(const ObjectState &, const vvApplicationState &) override {}
     bool needsUpdate(const ObjectState &objState,
                      const LODData &result) const override;
-    void execute() override;
+    void execute() override {}
     void exportResult(LODData &result) const override;
   };
 
-  // HiRes LOD: ----------------------------------------------------------------
-  // Run vtkCompositeDataGeometryFilter on the full dataset:
-  struct HiResDataPipeline : public LoResDataPipeline
-  {
-    vtkDataObject* input(const vvApplicationState &state) const override;
-  };
-
-  // Shared: LODData and RenderPipeline are shared between LoRes and HiRes. ----
   struct GeometryLODData : public Superclass::LODData
   {
-    vtkSmartPointer<vtkDataObject> geometry;
+    bool exported{false};
   };
 
+  // The actors of the remote ParaView render view are mirrored into the
+  // context's renderer through remoteActors, which only touches the actors
+  // that changed since the last update. The pipelines of all contexts share
+  // the registry of the mvGeometry, which tracks each context's renderer
+  // separately, so the LoRes and HiRes pipelines of a context install and
+  // refresh each actor once.
   struct GeometryRenderPipeline : public Superclass::RenderPipeline
   {
-    vtkNew<vtkPolyDataMapper> mapper;
-    vtkNew<vtkActor> actor;
+    std::shared_ptr<mvActorRegistry> remoteActors;
 
     void init(const ObjectState &objState,
-              vvContextState &contextState) override;
+              vvContextState &contextState) override {}
     void update(const ObjectState &objState,
                 const vvApplicationState &appState,
                 const vvContextState &contextState,
                 const LODData &result) override;
-    void disable();
   };
 
   // mvGeometry API ------------------------------------------------------------
@@ -115,6 +106,9 @@ private:
   // Not implemented -- disable copy:
   mvGeometry(const mvGeometry&);
   mvGeometry& operator=(const mvGeometry&);
+
+private:
+  std::shared_ptr<mvActorRegistry> m_remoteActors;
 };
 
 #endif // MVGEOMETRY_H
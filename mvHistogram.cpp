@@ -0,0 +1,141 @@
+#include "mvHistogram.h"
+
+#include <vtkDataArray.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+#include <vtkType.h>
+
+#include <algorithm>
+
+namespace {
+
+const vtkIdType ChunkSize = 65536;
+
+// Values are converted to bin indices in batches of this size, which lets the
+// compiler vectorize the conversion. Only the scatter into the bins is scalar.
+const int BatchSize = 256;
+
+using Bins = std::vector<unsigned long long>;
+
+//------------------------------------------------------------------------------
+// Bin tuples [begin, end) of the first component. bins has numberOfBins + 1
+// entries, NaNs are counted in the last one and dropped later.
+template <typename T>
+void binValues(const T *data, vtkIdType begin, vtkIdType end, int stride,
+               double min, double scale, int numberOfBins, Bins &bins)
+{
+  int indices[BatchSize];
+
+  for (vtkIdType batch = begin; batch < end; batch += BatchSize)
+    {
+    const int count = static_cast<int>(std::min<vtkIdType>(BatchSize,
+                                                           end - batch));
+    const T *values = data + batch * stride;
+    for (int i = 0; i < count; ++i)
+      {
+      const double v = static_cast<double>(values[i * stride]);
+      indices[i] = v == v
+          ? mvHistogram::binIndex(v, min, scale, numberOfBins)
+          : numberOfBins;
+      }
+    for (int i = 0; i < count; ++i)
+      {
+      ++bins[indices[i]];
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+struct Chunk
+{
+  vtkDataArray *array;
+  vtkIdType begin;
+  vtkIdType end;
+};
+
+//------------------------------------------------------------------------------
+struct HistogramFunctor
+{
+  const std::vector<Chunk> &Chunks;
+  double Min;
+  double Scale;
+  int NumberOfBins;
+  vtkSMPThreadLocal<Bins> LocalBins;
+
+  HistogramFunctor(const std::vector<Chunk> &chunks, double min, double scale,
+                   int numberOfBins)
+    : Chunks(chunks), Min(min), Scale(scale), NumberOfBins(numberOfBins)
+  {
+  }
+
+  void Initialize()
+  {
+    this->LocalBins.Local().assign(this->NumberOfBins + 1, 0);
+  }
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    Bins &bins = this->LocalBins.Local();
+    for (vtkIdType c = begin; c < end; ++c)
+      {
+      const Chunk &chunk = this->Chunks[c];
+      vtkDataArray *array = chunk.array;
+      switch (array->GetDataType())
+        {
+        vtkTemplateMacro(
+              binValues(static_cast<VTK_TT*>(array->GetVoidPointer(0)),
+                        chunk.begin, chunk.end,
+                        array->GetNumberOfComponents(), this->Min,
+                        this->Scale, this->NumberOfBins, bins));
+        default:
+          break;
+        }
+      }
+  }
+
+  void Reduce()
+  {
+  }
+};
+
+} // end anon namespace
+
+//------------------------------------------------------------------------------
+std::vector<float> mvHistogram::compute(const std::vector<vtkDataArray*> &arrays,
+                                        const double range[2],
+                                        int numberOfBins)
+{
+  std::vector<float> result(std::max(0, numberOfBins), 0.f);
+
+  const double spread = range[1] - range[0];
+  if (numberOfBins <= 0 || !(spread >= 1e-6)) // Constant data...
+    {
+    return result;
+    }
+
+  std::vector<Chunk> chunks;
+  for (vtkDataArray *array : arrays)
+    {
+    const vtkIdType numTuples = array ? array->GetNumberOfTuples() : 0;
+    for (vtkIdType begin = 0; begin < numTuples; begin += ChunkSize)
+      {
+      chunks.push_back(Chunk{array, begin,
+                             std::min(begin + ChunkSize, numTuples)});
+      }
+    }
+
+  HistogramFunctor functor(chunks, range[0],
+                           binScale(range, numberOfBins), numberOfBins);
+  vtkSMPTools::For(0, static_cast<vtkIdType>(chunks.size()), 1, functor);
+
+  // Merge the thread-local bins, dropping the NaN bin:
+  for (auto it = functor.LocalBins.begin(); it != functor.LocalBins.end(); ++it)
+    {
+    for (int b = 0; b < numberOfBins; ++b)
+      {
+      result[b] += static_cast<float>((*it)[b]);
+      }
+    }
+
+  return result;
+}
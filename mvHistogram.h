@@ -0,0 +1,61 @@
+#ifndef MVHISTOGRAM_H
+#define MVHISTOGRAM_H
+
+#include <vector>
+
+class vtkDataArray;
+
+/**
+ * @brief The mvHistogram class bins the first component of data arrays.
+ *
+ * Values are mapped onto the bins linearly, with range[0] at the start of the
+ * first bin and range[1] at the start of the last bin, matching the original
+ * MooseViewer histogram. Values outside of the range are clamped and NaNs are
+ * ignored. If the range is (nearly) empty, all bins are zero.
+ *
+ * The arrays are split into chunks that are processed in parallel with
+ * vtkSMPTools. Each thread accumulates into its own bins, which are merged at
+ * the end. The inner loops are typed for every VTK scalar type, so no virtual
+ * calls are made per value.
+ */
+class mvHistogram
+{
+public:
+  /**
+   * Bin the values of all @a arrays into @a numberOfBins bins spanning
+   * @a range. nullptr entries are skipped.
+   */
+  static std::vector<float> compute(const std::vector<vtkDataArray*> &arrays,
+                                    const double range[2], int numberOfBins);
+
+  /**
+   * The factor that maps (value - range[0]) onto bin indices for
+   * @a numberOfBins bins spanning @a range. 0 for an empty range, which
+   * puts every value into the first bin.
+   */
+  static double binScale(const double range[2], int numberOfBins)
+  {
+    const double spread = range[1] - range[0];
+    return spread > 0. ? (numberOfBins - 1) / spread : 0.;
+  }
+
+  /**
+   * The bin of @a value, clamped to [0, numberOfBins). @a scale is
+   * binScale(). @a value must not be NaN. Shared by all histograms so that
+   * they line up.
+   */
+  static int binIndex(double value, double min, double scale,
+                      int numberOfBins)
+  {
+    const double maxBin = static_cast<double>(numberOfBins - 1);
+    double x = (value - min) * scale;
+    x = x < 0. ? 0. : x;
+    x = x > maxBin ? maxBin : x;
+    return static_cast<int>(x);
+  }
+
+private:
+  mvHistogram(); // Not implemented.
+};
+
+#endif // MVHISTOGRAM_H
@@ -0,0 +1,138 @@
+#include "mvImageCache.h"
+
+#include <vtkDataObject.h>
+
+#include <cassert>
+#include <tuple>
+
+//------------------------------------------------------------------------------
+bool mvImageCache::Key::operator<(const Key &o) const
+{
+  return
+      std::tie(timeStep, dimensions[0], dimensions[1], dimensions[2],
+               fileName, variables) <
+      std::tie(o.timeStep, o.dimensions[0], o.dimensions[1], o.dimensions[2],
+               o.fileName, o.variables);
+}
+
+//------------------------------------------------------------------------------
+mvImageCache::mvImageCache()
+  : m_budget(static_cast<size_t>(512) * 1024 * 1024)
+{
+}
+
+//------------------------------------------------------------------------------
+mvImageCache::~mvImageCache()
+{
+}
+
+//------------------------------------------------------------------------------
+size_t mvImageCache::budget() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_budget;
+}
+
+//------------------------------------------------------------------------------
+void mvImageCache::setBudget(size_t bytes)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_budget = bytes;
+  this->evict();
+}
+
+//------------------------------------------------------------------------------
+void mvImageCache::clear()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_entries.clear();
+  m_lru.clear();
+  m_stats.bytes = 0;
+  m_stats.entries = 0;
+}
+
+//------------------------------------------------------------------------------
+void mvImageCache::store(const Key &key, vtkDataObject *image)
+{
+  if (!image)
+    {
+    return;
+    }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (m_entries.find(key) != m_entries.end())
+    {
+    return;
+    }
+
+  Entry entry;
+  entry.image.TakeReference(image->NewInstance());
+  entry.image->ShallowCopy(image);
+  entry.bytes = static_cast<size_t>(image->GetActualMemorySize()) * 1024;
+
+  // Don't bother with entries that can never fit:
+  if (entry.bytes > m_budget)
+    {
+    return;
+    }
+
+  m_lru.push_front(key);
+  entry.lru = m_lru.begin();
+  m_entries.insert(std::make_pair(key, entry));
+  m_stats.bytes += entry.bytes;
+  ++m_stats.entries;
+
+  this->evict();
+}
+
+//------------------------------------------------------------------------------
+vtkSmartPointer<vtkDataObject> mvImageCache::find(const Key &key)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto it = m_entries.find(key);
+  if (it == m_entries.end())
+    {
+    ++m_stats.misses;
+    return nullptr;
+    }
+
+  // Mark as most recently used:
+  m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+  ++m_stats.hits;
+
+  vtkSmartPointer<vtkDataObject> result;
+  result.TakeReference(it->second.image->NewInstance());
+  result->ShallowCopy(it->second.image);
+  return result;
+}
+
+//------------------------------------------------------------------------------
+bool mvImageCache::contains(const Key &key) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_entries.find(key) != m_entries.end();
+}
+
+//------------------------------------------------------------------------------
+mvImageCache::Statistics mvImageCache::statistics() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stats;
+}
+
+//------------------------------------------------------------------------------
+void mvImageCache::evict()
+{
+  while (m_stats.bytes > m_budget && !m_lru.empty())
+    {
+    auto it = m_entries.find(m_lru.back());
+    assert(it != m_entries.end());
+    m_stats.bytes -= it->second.bytes;
+    --m_stats.entries;
+    ++m_stats.evictions;
+    m_entries.erase(it);
+    m_lru.pop_back();
+    }
+}
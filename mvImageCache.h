@@ -0,0 +1,103 @@
+#ifndef MVIMAGECACHE_H
+#define MVIMAGECACHE_H
+
+#include <vtkSmartPointer.h>
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+
+class vtkDataObject;
+
+/**
+ * @brief The mvImageCache class holds resampled images under a fixed memory
+ * budget.
+ *
+ * Images are keyed by the source data (file, timestep and the variables that
+ * were loaded) and the sampling dimensions. The cache is shared by mvReader's
+ * reduced dataset and mvVolume's HiRes pyramid, so a configuration that was
+ * resampled once, by either of them, is served from here afterwards.
+ *
+ * Entries are evicted in least-recently-used order once budget() is
+ * exceeded. All methods are thread-safe.
+ */
+class mvImageCache
+{
+public:
+  struct Key
+  {
+    Key() : timeStep(-1), dimensions{0, 0, 0} {}
+    bool operator<(const Key &o) const;
+
+    std::string fileName;
+    int timeStep;
+    std::set<std::string> variables;
+    int dimensions[3];
+  };
+
+  /** Cache effectiveness counters, see statistics(). */
+  struct Statistics
+  {
+    Statistics() : hits(0), misses(0), evictions(0), bytes(0), entries(0) {}
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long evictions;
+    size_t bytes;
+    size_t entries;
+  };
+
+  mvImageCache();
+  ~mvImageCache();
+
+  /** The maximum number of bytes held by the cache. @{ */
+  size_t budget() const;
+  void setBudget(size_t bytes);
+  /** @} */
+
+  /** Remove all entries. The statistics are preserved. */
+  void clear();
+
+  /** Store a shallow copy of @a image under @a key. */
+  void store(const Key &key, vtkDataObject *image);
+
+  /**
+   * Returns a shallow copy of the image stored under @a key, or nullptr.
+   * Counts as a hit or miss.
+   */
+  vtkSmartPointer<vtkDataObject> find(const Key &key);
+
+  /** Returns true if @a key is cached. Does not affect the statistics. */
+  bool contains(const Key &key) const;
+
+  /** Returns a snapshot of the hit/miss/eviction counters and memory use. */
+  Statistics statistics() const;
+
+private:
+  struct Entry
+  {
+    Entry() : bytes(0) {}
+    vtkSmartPointer<vtkDataObject> image;
+    size_t bytes;
+    std::list<Key>::iterator lru;
+  };
+
+  // m_mutex must be held:
+  void evict();
+
+private:
+  // Not implemented -- disable copy:
+  mvImageCache(const mvImageCache&);
+  mvImageCache& operator=(const mvImageCache&);
+
+private:
+  mutable std::mutex m_mutex;
+  size_t m_budget;
+  std::map<Key, Entry> m_entries;
+  std::list<Key> m_lru; // Most recently used first.
+  Statistics m_stats;
+};
+
+#endif // MVIMAGECACHE_H
@@ -0,0 +1,581 @@
+#include "mvParaViewSync.h"
+
+#include <vtkCommand.h>
+#include <vtkNetworkAccessManager.h>
+#include <vtkProcessModule.h>
+#include <vtkPVRenderView.h>
+#include <vtkSMProxy.h>
+#include <vtkSMProxyManager.h>
+#include <vtkSMProxySelectionModel.h>
+#include <vtkSMRenderViewProxy.h>
+#include <vtkSMSessionClient.h>
+#include <vtkSMSessionProxyManager.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+extern vtkSMRenderViewProxy* RVP;
+
+namespace {
+
+// Returns the selection model @a name of @a spxm, registering an empty one
+// if the server has none:
+vtkSMProxySelectionModel* selectionModel(vtkSMSessionProxyManager *spxm,
+                                         const char *name)
+{
+  vtkSMProxySelectionModel *selmodel = spxm->GetSelectionModel(name);
+  if (!selmodel)
+    {
+    selmodel = vtkSMProxySelectionModel::New();
+    spxm->RegisterSelectionModel(name, selmodel);
+    selmodel->FastDelete();
+    }
+  return selmodel;
+}
+
+} // end anon namespace
+
+//------------------------------------------------------------------------------
+struct mvParaViewSync::Attempt
+{
+  std::string url;
+
+  std::mutex mutex;
+  std::condition_variable finished;
+  bool done{false};
+  // The connected session, or nullptr if the attempt failed:
+  vtkSmartPointer<vtkSMSessionClient> session;
+};
+
+//------------------------------------------------------------------------------
+void mvParaViewSync::Changes::merge(const Changes &other)
+{
+  this->proxies.insert(other.proxies.begin(), other.proxies.end());
+  this->registration = this->registration || other.registration;
+  this->camera = this->camera || other.camera;
+  this->delivered = this->delivered || other.delivered;
+}
+
+//------------------------------------------------------------------------------
+mvParaViewSync::mvParaViewSync()
+  : m_status(Status::Stopped),
+    m_quit(false),
+    m_remoteLOD(true),
+    m_deliveryPending(false),
+    m_frames(0),
+    m_connectTimeout(5.),
+    m_sessionId(0),
+    m_observers{0, 0, 0, 0},
+    m_delivered(Delivered::Nothing),
+    m_decimatedFrame(0)
+{
+}
+
+//------------------------------------------------------------------------------
+mvParaViewSync::~mvParaViewSync()
+{
+  this->stop();
+
+  // Normally shutdown() dealt with a pending attempt already:
+  if (m_attemptThread.joinable())
+    {
+    m_attemptThread.detach();
+    }
+}
+
+//------------------------------------------------------------------------------
+void mvParaViewSync::start(const std::string &url)
+{
+  this->stop();
+
+  m_url = url;
+    {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_quit = false;
+    m_status = Status::Connecting;
+    }
+  m_thread = std::thread(&mvParaViewSync::run, this);
+}
+
+//------------------------------------------------------------------------------
+void mvParaViewSync::stop()
+{
+  if (m_thread.joinable())
+    {
+      {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_quit = true;
+      }
+    m_wake.notify_one();
+    m_thread.join();
+    }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_status = Status::Stopped;
+  m_changes = Changes();
+  m_deliveryPending = false;
+}
+
+//------------------------------------------------------------------------------
+bool mvParaViewSync::shutdown(int ms)
+{
+  this->stop();
+  if (!m_attempt)
+    {
+    return true;
+    }
+
+  bool done;
+    {
+    std::unique_lock<std::mutex> lock(m_attempt->mutex);
+    done = m_attempt->finished.wait_for(
+          lock, std::chrono::milliseconds(ms),
+          [this]() { return m_attempt->done; });
+    }
+  if (!done)
+    {
+    std::cerr << "The connection attempt to " << m_attempt->url
+              << " did not finish, leaving it to the process exit.\n";
+    m_attemptThread.detach();
+    m_attempt.reset();
+    return false;
+    }
+
+  this->finishAttempt(false);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+mvParaViewSync::Status mvParaViewSync::status() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_status;
+}
+
+//------------------------------------------------------------------------------
+mvParaViewSync::Changes mvParaViewSync::takeChanges()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_frames;
+  Changes result;
+  std::swap(result, m_changes);
+  return result;
+}
+
+//------------------------------------------------------------------------------
+bool mvParaViewSync::remoteLOD() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_remoteLOD;
+}
+
+//------------------------------------------------------------------------------
+void mvParaViewSync::setRemoteLOD(bool lod)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_remoteLOD = lod;
+}
+
+//------------------------------------------------------------------------------
+bool mvParaViewSync::deliveryPending() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_deliveryPending;
+}
+
+//------------------------------------------------------------------------------
+void mvParaViewSync::run()
+{
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point connecting = Clock::now();
+  bool reported = false;
+  int retry = RetryMilliseconds;
+
+  for (;;)
+    {
+    if (!m_session)
+      {
+      if (!m_attempt)
+        {
+        this->startAttempt();
+        }
+
+      bool done;
+        {
+        std::lock_guard<std::mutex> lock(m_attempt->mutex);
+        done = m_attempt->done;
+        }
+
+      vtkSmartPointer<vtkSMSessionClient> session;
+      if (done)
+        {
+        // An attempt abandoned by stop() may be for another server. Its
+        // session is closed, and a new attempt is started:
+        const bool current = m_attempt->url == m_url;
+        session = this->finishAttempt(current);
+        if (!current)
+          {
+          continue;
+          }
+        }
+
+      if (session)
+        {
+        this->connect(session);
+        std::cerr << "Connected to ParaView server at " << m_url << ".\n";
+        retry = RetryMilliseconds;
+        reported = false;
+
+        // Resynchronize the view and its camera on the render thread:
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_status = Status::Connected;
+        if (m_view)
+          {
+          m_changes.proxies.insert(m_view->GetGlobalID());
+          }
+        m_changes.camera = true;
+        continue;
+        }
+
+      const double waited =
+          std::chrono::duration<double>(Clock::now() - connecting).count();
+      if (!reported && waited >= m_connectTimeout)
+        {
+        std::cerr << "No ParaView server at " << m_url << " after " << waited
+                  << " s, rendering locally. Retrying in the background.\n";
+        reported = true;
+        }
+
+      if (!done)
+        {
+        if (!this->idle(AttemptPollMilliseconds))
+          {
+          break;
+          }
+        continue;
+        }
+
+      if (!this->idle(retry))
+        {
+        break;
+        }
+      retry = std::min(2 * retry, static_cast<int>(MaxRetryMilliseconds));
+      continue;
+      }
+
+    // Process the pending events, a bounded batch per lock. The observers
+    // record what they changed.
+    bool lost = false;
+      {
+      std::lock_guard<std::mutex> io(m_ioMutex);
+      if (m_session->IsNotBusy())
+        {
+        vtkNetworkAccessManager *network =
+            vtkProcessModule::GetProcessModule()->GetNetworkAccessManager();
+        int result = 0;
+        for (int i = 0; i < MaxEventsPerPoll; ++i)
+          {
+          if ((result = network->ProcessEvents(PollMilliseconds)) <= 0)
+            {
+            break;
+            }
+          }
+        lost = result < 0 || !m_session->GetIsAlive();
+        }
+
+      // Pick up a render view that was created after connecting:
+      if (!lost && !m_view)
+        {
+        vtkSMProxySelectionModel *selmodel =
+            m_proxyManager->GetSelectionModel("ActiveView");
+        m_view = vtkSMRenderViewProxy::SafeDownCast(
+              selmodel ? selmodel->GetCurrentProxy() : nullptr);
+        if (m_view)
+          {
+          m_view->UpdateVTKObjects();
+          RVP = m_view;
+          m_delivered = Delivered::Nothing;
+
+          std::lock_guard<std::mutex> lock(m_mutex);
+          m_changes.proxies.insert(m_view->GetGlobalID());
+          m_changes.camera = true;
+          }
+        }
+
+      if (!lost && m_view)
+        {
+        this->deliver();
+        }
+
+      if (lost)
+        {
+        std::cerr << "Lost the connection to the ParaView server at "
+                  << m_url << ", reconnecting.\n";
+        this->disconnect();
+        }
+      }
+
+    if (lost)
+      {
+        {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_status = Status::Connecting;
+        }
+      connecting = Clock::now();
+      if (!this->idle(retry))
+        {
+        break;
+        }
+      continue;
+      }
+
+    if (!this->idle(IdleMilliseconds))
+      {
+      break;
+      }
+    }
+
+  std::lock_guard<std::mutex> io(m_ioMutex);
+  if (m_session)
+    {
+    this->disconnect();
+    }
+}
+
+//------------------------------------------------------------------------------
+void mvParaViewSync::startAttempt()
+{
+  std::shared_ptr<Attempt> attempt = std::make_shared<Attempt>();
+  attempt->url = m_url;
+  m_attempt = attempt;
+
+  // Connect() cannot be interrupted, so the thread only holds the attempt,
+  // and may outlive the worker. Nothing else uses the network while
+  // disconnected, and the render thread must not wait for a slow server, so
+  // this runs unlocked. A new attempt is only started once this one is
+  // finished, see finishAttempt().
+  m_attemptThread = std::thread([attempt]()
+    {
+    vtkSmartPointer<vtkSMSessionClient> session =
+        vtkSmartPointer<vtkSMSessionClient>::New();
+    const bool connected = session->Connect(attempt->url.c_str());
+
+    std::lock_guard<std::mutex> lock(attempt->mutex);
+    attempt->done = true;
+    if (connected)
+      {
+      attempt->session = session;
+      }
+    attempt->finished.notify_all();
+    });
+}
+
+//------------------------------------------------------------------------------
+vtkSmartPointer<vtkSMSessionClient> mvParaViewSync::finishAttempt(bool keep)
+{
+  // The thread is done with the attempt, only its exit is left to wait for:
+  if (m_attemptThread.joinable())
+    {
+    m_attemptThread.join();
+    }
+
+  // The session was never registered, and the render thread does not use
+  // the ServerManager while disconnected, so it is closed unlocked:
+  vtkSmartPointer<vtkSMSessionClient> session = m_attempt->session;
+  m_attempt.reset();
+  if (session && !keep)
+    {
+    session->CloseSession();
+    session = nullptr;
+    }
+  return session;
+}
+
+//------------------------------------------------------------------------------
+void mvParaViewSync::connect(vtkSMSessionClient *session)
+{
+  // The render thread leaves the ServerManager alone while RVP is nullptr,
+  // so the proxies are resynchronized without holding m_ioMutex, and only
+  // the view is published under it:
+  m_sessionId =
+      vtkProcessModule::GetProcessModule()->RegisterSession(session);
+  vtkSMProxyManager::GetProxyManager()->SetActiveSession(m_sessionId);
+
+  vtkSMSessionProxyManager *spxm = session->GetSessionProxyManager();
+  spxm->UpdateFromRemote();
+
+  // Setup the active-view and active-sources selection models:
+  selectionModel(spxm, "ActiveSources");
+  vtkSMRenderViewProxy *view = vtkSMRenderViewProxy::SafeDownCast(
+        selectionModel(spxm, "ActiveView")->GetCurrentProxy());
+  if (view)
+    {
+    view->UpdateVTKObjects();
+    }
+  else
+    {
+    std::cerr << "The ParaView server has no active render view.\n";
+    }
+
+  m_observers[0] = spxm->AddObserver(
+        vtkCommand::RegisterEvent, this, &mvParaViewSync::onRegistration);
+  m_observers[1] = spxm->AddObserver(
+        vtkCommand::UnRegisterEvent, this, &mvParaViewSync::onRegistration);
+  m_observers[2] = spxm->AddObserver(
+        vtkCommand::PropertyModifiedEvent, this,
+        &mvParaViewSync::onPropertyModified);
+  m_observers[3] = spxm->AddObserver(
+        vtkCommand::StateChangedEvent, this, &mvParaViewSync::onStateChanged);
+
+  m_session = session;
+  m_proxyManager = spxm;
+  m_view = view;
+  m_delivered = Delivered::Nothing;
+
+  std::lock_guard<std::mutex> io(m_ioMutex);
+  RVP = view;
+}
+
+//------------------------------------------------------------------------------
+void mvParaViewSync::disconnect()
+{
+  RVP = nullptr;
+
+  for (unsigned long &tag : m_observers)
+    {
+    m_proxyManager->RemoveObserver(tag);
+    tag = 0;
+    }
+
+  vtkProcessModule::GetProcessModule()->UnRegisterSession(m_sessionId);
+  m_session = nullptr;
+  m_sessionId = 0;
+  m_proxyManager = nullptr;
+  m_view = nullptr;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_deliveryPending = false;
+}
+
+//------------------------------------------------------------------------------
+void mvParaViewSync::deliver()
+{
+  bool remoteLOD;
+  unsigned long frames;
+    {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    remoteLOD = m_remoteLOD;
+    frames = m_frames;
+    }
+
+  if (m_delivered == Delivered::Decimated)
+    {
+    // Leave the render thread a frame to mirror the decimated geometry
+    // before it is replaced. A frame is done when the next one has started:
+    if (frames < m_decimatedFrame + 2 &&
+        std::chrono::steady_clock::now() - m_decimatedTime <
+          std::chrono::milliseconds(DecimatedMilliseconds))
+      {
+      return;
+      }
+    m_view->StillRender();
+    m_delivered = Delivered::Full;
+    }
+  else if (m_delivered == Delivered::Nothing || m_view->GetNeedsUpdate())
+    {
+    m_delivered = Delivered::Full;
+    if (remoteLOD)
+      {
+      // An interactive render delivers the LOD geometry if the view's
+      // geometry is above its LODThreshold. Below it, the full-resolution
+      // geometry is delivered right away:
+      m_view->InteractiveRender();
+      vtkPVRenderView *view =
+          vtkPVRenderView::SafeDownCast(m_view->GetClientSideObject());
+      if (view && view->GetUsedLODForLastRender())
+        {
+        m_delivered = Delivered::Decimated;
+        m_decimatedFrame = frames;
+        m_decimatedTime = std::chrono::steady_clock::now();
+        }
+      }
+    else
+      {
+      m_view->StillRender();
+      }
+    }
+  else
+    {
+    return;
+    }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_changes.delivered = true;
+  m_deliveryPending = m_delivered == Delivered::Decimated;
+}
+
+//------------------------------------------------------------------------------
+bool mvParaViewSync::idle(int ms)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_wake.wait_for(lock, std::chrono::milliseconds(ms),
+                  [this]() { return m_quit; });
+  return !m_quit;
+}
+
+//------------------------------------------------------------------------------
+void mvParaViewSync::onRegistration(vtkObject *, unsigned long, void *data)
+{
+  const vtkSMProxyManager::RegisteredProxyInformation *info =
+      static_cast<vtkSMProxyManager::RegisteredProxyInformation*>(data);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_changes.registration = true;
+  if (info && info->Proxy)
+    {
+    m_changes.proxies.insert(info->Proxy->GetGlobalID());
+    }
+}
+
+//------------------------------------------------------------------------------
+void mvParaViewSync::onPropertyModified(vtkObject *, unsigned long,
+                                        void *data)
+{
+  const vtkSMProxyManager::ModifiedPropertyInformation *info =
+      static_cast<vtkSMProxyManager::ModifiedPropertyInformation*>(data);
+  if (info)
+    {
+    this->proxyChanged(info->Proxy, info->PropertyName);
+    }
+}
+
+//------------------------------------------------------------------------------
+void mvParaViewSync::onStateChanged(vtkObject *, unsigned long, void *data)
+{
+  const vtkSMProxyManager::StateChangedInformation *info =
+      static_cast<vtkSMProxyManager::StateChangedInformation*>(data);
+  if (info)
+    {
+    this->proxyChanged(info->Proxy, nullptr);
+    }
+}
+
+//------------------------------------------------------------------------------
+void mvParaViewSync::proxyChanged(vtkSMProxy *proxy, const char *propertyName)
+{
+  if (!proxy)
+    {
+    return;
+    }
+
+  // A reloaded view state may contain a new camera:
+  const bool camera =
+      proxy == m_view.Get() &&
+      (!propertyName || std::strncmp(propertyName, "Camera", 6) == 0);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_changes.proxies.insert(proxy->GetGlobalID());
+  m_changes.camera = m_changes.camera || camera;
+}
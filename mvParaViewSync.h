@@ -0,0 +1,251 @@
+#ifndef MVPARAVIEWSYNC_H
+#define MVPARAVIEWSYNC_H
+
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+class vtkObject;
+class vtkSMProxy;
+class vtkSMRenderViewProxy;
+class vtkSMSessionClient;
+class vtkSMSessionProxyManager;
+
+/**
+ * @brief The mvParaViewSync class connects to a ParaView server and follows
+ * the shared session without blocking the render thread.
+ *
+ * start() returns immediately. A worker thread connects to the server,
+ * resolves the active render view and then processes the network events of
+ * the session. Until it is connected, the application renders its local
+ * pipelines only. Each connection attempt runs on a thread of its own, which
+ * the worker polls, so that neither the worker nor stop() wait for a server
+ * that does not answer. shutdown() bounds the wait for such an attempt
+ * before the ServerManager is finalized. If the server does not answer within
+ * connectTimeout(), a notice is printed and the worker keeps retrying in the
+ * background. A
+ * dropped session is torn down and re-established the same way, and all
+ * proxies are resynchronized once it is back.
+ *
+ * The session proxy manager notifies the proxy changes caused by the events
+ * (e.g. another client editing a pipeline), and they are recorded as Changes.
+ * The render thread collects them once per frame with takeChanges(), and only
+ * talks to the server when there is something to apply.
+ *
+ * The geometry of the view is delivered by the worker too, like the local
+ * LoRes/HiRes scheme: when the view needs an update, the server's decimated
+ * LOD geometry is delivered first (see setRemoteLOD()), and the
+ * full-resolution geometry once the render thread had a frame to show it.
+ * The render thread mirrors the delivered geometry (see mvActorRegistry) and
+ * never waits for a delivery.
+ *
+ * The ServerManager is not thread-safe. The worker holds mutex() while it
+ * processes events, and the render thread must hold it whenever it uses the
+ * session's proxies, including the global RVP, which the worker sets to the
+ * render view of the current session (nullptr while disconnected). The
+ * render thread does not use the ServerManager while RVP is nullptr, so the
+ * worker sets up and resynchronizes a new session without the mutex, and
+ * only takes it to publish RVP. The render thread only takes it with std::try_to_lock and
+ * defers its remote work to a later frame while the worker holds it. The
+ * worker processes at most MaxEventsPerPoll events per lock and idles
+ * between polls, so that the render thread gets the mutex even while the
+ * server keeps sending.
+ */
+class mvParaViewSync
+{
+public:
+  /** Timeout of a single network poll, and idle time between polls. */
+  enum { PollMilliseconds = 1, IdleMilliseconds = 4 };
+
+  /** Events processed before the worker releases mutex(). */
+  enum { MaxEventsPerPoll = 64 };
+
+  /** Delays between connection attempts, doubling up to the maximum. */
+  enum { RetryMilliseconds = 1000, MaxRetryMilliseconds = 30000 };
+
+  /** Interval at which a pending connection attempt is checked. */
+  enum { AttemptPollMilliseconds = 50 };
+
+  /** Time shutdown() waits for a pending connection attempt by default. */
+  enum { ShutdownMilliseconds = 2000 };
+
+  /**
+   * Longest time the decimated geometry is kept before the full resolution
+   * is delivered, if the render thread does not render frames.
+   */
+  enum { DecimatedMilliseconds = 500 };
+
+  enum class Status
+    {
+    Stopped,
+    Connecting,
+    Connected
+    };
+
+  /** Changes notified by the session since the last takeChanges(). */
+  struct Changes
+  {
+    // Global ids of the proxies that were modified or reloaded:
+    std::set<vtkTypeUInt32> proxies;
+    // Proxies were registered or unregistered, or a session was
+    // (re)established:
+    bool registration{false};
+    // The camera of the view changed:
+    bool camera{false};
+    // The worker delivered new geometry to the view's representations:
+    bool delivered{false};
+
+    bool empty() const
+    {
+      return this->proxies.empty() && !this->registration && !this->camera &&
+          !this->delivered;
+    }
+    void merge(const Changes &other);
+  };
+
+  mvParaViewSync();
+  ~mvParaViewSync();
+
+  /**
+   * Seconds to wait for the first connection before reporting that the
+   * application runs without a server. Default is 5.
+   * @{
+   */
+  double connectTimeout() const { return m_connectTimeout; }
+  void setConnectTimeout(double seconds) { m_connectTimeout = seconds; }
+  /** @} */
+
+  /**
+   * Connect to the server at @a url in the background and follow the
+   * session. Stops a previous session first.
+   */
+  void start(const std::string &url);
+
+  /**
+   * Stop the worker and close the session. A connection attempt in progress
+   * is abandoned: it completes in the background, and its session is used by
+   * the next start() with the same url, or closed. Only one attempt runs at
+   * a time, the next start() waits for it in the background.
+   */
+  void stop();
+
+  /**
+   * stop(), then wait up to @a ms for an abandoned connection attempt and
+   * close its session. The attempt uses the ServerManager, so the
+   * ServerManager must only be finalized if this returns true. Otherwise the
+   * attempt is still blocked on the server and is left to the process exit.
+   */
+  bool shutdown(int ms = ShutdownMilliseconds);
+
+  /** The state of the connection. */
+  Status status() const;
+
+  /**
+   * Return the changes since the last call, and forget them. Call once per
+   * frame, the frames are counted to pace the deliveries.
+   */
+  Changes takeChanges();
+
+  /**
+   * Deliver the server's decimated geometry before the full resolution
+   * (default on). The server only decimates geometry above the view's
+   * LODThreshold, which is shared with the other clients and not changed
+   * here.
+   * @{
+   */
+  bool remoteLOD() const;
+  void setRemoteLOD(bool lod);
+  /** @} */
+
+  /** True while the full-resolution geometry is still to be delivered. */
+  bool deliveryPending() const;
+
+  /** Guards the ServerManager against the worker. */
+  std::mutex& mutex() { return m_ioMutex; }
+
+private:
+  // A connection attempt, shared with the thread that runs it:
+  struct Attempt;
+
+  void run();
+
+  // Worker: start a connection attempt to m_url on m_attemptThread.
+  void startAttempt();
+  // Join the thread of the finished m_attempt, and close its session unless
+  // @a keep. Returns the session otherwise.
+  vtkSmartPointer<vtkSMSessionClient> finishAttempt(bool keep);
+  // Worker: set up the connected @a session, and publish its view as RVP
+  // under m_ioMutex.
+  void connect(vtkSMSessionClient *session);
+  // Worker, with m_ioMutex held: close the session.
+  void disconnect();
+  // Worker, with m_ioMutex held: deliver the geometry of m_view that
+  // changed, a level per call.
+  void deliver();
+
+  // Wait for @a ms, or until stop(). Returns false on stop().
+  bool idle(int ms);
+
+  // Observers of the session proxy manager, called on the worker thread:
+  void onRegistration(vtkObject *caller, unsigned long event, void *data);
+  void onPropertyModified(vtkObject *caller, unsigned long event, void *data);
+  void onStateChanged(vtkObject *caller, unsigned long event, void *data);
+  void proxyChanged(vtkSMProxy *proxy, const char *propertyName);
+
+private:
+  // Not implemented -- disable copy:
+  mvParaViewSync(const mvParaViewSync&);
+  mvParaViewSync& operator=(const mvParaViewSync&);
+
+private:
+  std::mutex m_ioMutex;
+
+  // Protects m_changes, m_status, m_quit, m_remoteLOD, m_deliveryPending and
+  // m_frames:
+  mutable std::mutex m_mutex;
+  std::condition_variable m_wake;
+  Changes m_changes;
+  Status m_status;
+  bool m_quit;
+  bool m_remoteLOD;
+  bool m_deliveryPending;
+  unsigned long m_frames;
+
+  std::string m_url;
+  double m_connectTimeout;
+
+  // Worker only, and kept across stop() while it is pending. The thread only
+  // uses the attempt, not this object:
+  std::shared_ptr<Attempt> m_attempt;
+  std::thread m_attemptThread;
+
+  // Worker only:
+  vtkSmartPointer<vtkSMSessionClient> m_session;
+  vtkIdType m_sessionId;
+  vtkSmartPointer<vtkSMSessionProxyManager> m_proxyManager;
+  vtkSmartPointer<vtkSMRenderViewProxy> m_view;
+  unsigned long m_observers[4];
+
+  // Worker only: the level of the last delivery to m_view, and when the
+  // decimated geometry was delivered.
+  enum class Delivered
+    {
+    Nothing,
+    Decimated,
+    Full
+    };
+  Delivered m_delivered;
+  unsigned long m_decimatedFrame;
+  std::chrono::steady_clock::time_point m_decimatedTime;
+
+  std::thread m_thread;
+};
+
+#endif // MVPARAVIEWSYNC_H
@@ -0,0 +1,636 @@
+#include "mvPlaneCutter.h"
+
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkCellType.h>
+#include <vtkIdList.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkUnstructuredGrid.h>
+
+#include "mvCellLocator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace {
+
+enum Shape
+{
+  Tetra = 0,
+  Hexahedron,
+  Voxel,
+  Wedge,
+  Pyramid,
+  Triangle,
+  Quad,
+  Pixel,
+  NumberOfShapes
+};
+
+// Dimension, corner count and edges of each shape, in VTK's point ordering:
+struct ShapeInfo
+{
+  int dimension;
+  int numberOfCorners;
+  int numberOfEdges;
+  int edges[12][2];
+};
+
+const ShapeInfo Shapes[NumberOfShapes] = {
+  // Tetra
+  { 3, 4, 6, { {0, 1}, {1, 2}, {2, 0}, {0, 3}, {1, 3}, {2, 3} } },
+  // Hexahedron
+  { 3, 8, 12, { {0, 1}, {1, 2}, {3, 2}, {0, 3}, {4, 5}, {5, 6}, {7, 6},
+                {4, 7}, {0, 4}, {1, 5}, {3, 7}, {2, 6} } },
+  // Voxel
+  { 3, 8, 12, { {0, 1}, {1, 3}, {2, 3}, {0, 2}, {4, 5}, {5, 7}, {6, 7},
+                {4, 6}, {0, 4}, {1, 5}, {2, 6}, {3, 7} } },
+  // Wedge
+  { 3, 6, 9, { {0, 1}, {1, 2}, {2, 0}, {3, 4}, {4, 5}, {5, 3}, {0, 3},
+               {1, 4}, {2, 5} } },
+  // Pyramid
+  { 3, 5, 8, { {0, 1}, {1, 2}, {2, 3}, {3, 0}, {0, 4}, {1, 4}, {2, 4},
+               {3, 4} } },
+  // Triangle
+  { 2, 3, 3, { {0, 1}, {1, 2}, {2, 0} } },
+  // Quad
+  { 2, 4, 4, { {0, 1}, {1, 2}, {2, 3}, {3, 0} } },
+  // Pixel
+  { 2, 4, 4, { {0, 1}, {1, 3}, {3, 2}, {2, 0} } }
+};
+
+//------------------------------------------------------------------------------
+// Returns the Shape used to cut cells of the given VTK type, or -1.
+int shapeOf(int cellType)
+{
+  switch (cellType)
+    {
+    case VTK_TETRA:
+    case VTK_QUADRATIC_TETRA:
+      return Tetra;
+
+    case VTK_HEXAHEDRON:
+    case VTK_QUADRATIC_HEXAHEDRON:
+    case VTK_TRIQUADRATIC_HEXAHEDRON:
+      return Hexahedron;
+
+    case VTK_VOXEL:
+      return Voxel;
+
+    case VTK_WEDGE:
+    case VTK_QUADRATIC_WEDGE:
+    case VTK_BIQUADRATIC_QUADRATIC_WEDGE:
+      return Wedge;
+
+    case VTK_PYRAMID:
+    case VTK_QUADRATIC_PYRAMID:
+      return Pyramid;
+
+    case VTK_TRIANGLE:
+    case VTK_QUADRATIC_TRIANGLE:
+    case VTK_BIQUADRATIC_TRIANGLE:
+      return Triangle;
+
+    case VTK_QUAD:
+    case VTK_QUADRATIC_QUAD:
+    case VTK_BIQUADRATIC_QUAD:
+      return Quad;
+
+    case VTK_PIXEL:
+      return Pixel;
+
+    default:
+      return -1;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Set @a bit in masks[i] if box i, given as center and half extent, straddles
+// the plane n.x = d. The box spans [s - r, s + r] along the normal. A flat
+// loop over the buffers without calls or branches, so that the compiler can
+// vectorize it.
+void cullBoxes(const double *cx, const double *cy, const double *cz,
+               const double *ex, const double *ey, const double *ez,
+               size_t count, const double n[3], const double an[3], double d,
+               unsigned int bit, unsigned int *masks)
+{
+  const double nx = n[0];
+  const double ny = n[1];
+  const double nz = n[2];
+  const double ax = an[0];
+  const double ay = an[1];
+  const double az = an[2];
+  for (size_t i = 0; i < count; ++i)
+    {
+    const double s = nx * cx[i] + ny * cy[i] + nz * cz[i] - d;
+    const double r = ax * ex[i] + ay * ey[i] + az * ez[i];
+    masks[i] |= static_cast<unsigned int>((s <= r) & (s >= -r)) << bit;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Signed distances of the points (x, y, z) to the plane n.x = d. Vectorizes
+// like cullBoxes().
+void planeDistances(const double *x, const double *y, const double *z,
+                    size_t count, const double n[3], double d, double *dist)
+{
+  const double nx = n[0];
+  const double ny = n[1];
+  const double nz = n[2];
+  for (size_t i = 0; i < count; ++i)
+    {
+    dist[i] = nx * x[i] + ny * y[i] + nz * z[i] - d;
+    }
+}
+
+} // end anon namespace
+
+//------------------------------------------------------------------------------
+mvPlaneCutter::mvPlaneCutter()
+  : m_preparedPoints(nullptr),
+    m_preparedPointsMTime(0),
+    m_preparedCells(nullptr),
+    m_preparedCellsMTime(0)
+{
+}
+
+//------------------------------------------------------------------------------
+mvPlaneCutter::~mvPlaneCutter()
+{
+}
+
+//------------------------------------------------------------------------------
+void mvPlaneCutter::setInput(vtkUnstructuredGrid *input)
+{
+  m_input = input;
+
+  vtkPoints *points = input ? input->GetPoints() : nullptr;
+  vtkCellArray *cells = input ? input->GetCells() : nullptr;
+  const unsigned long pointsMTime = points ? points->GetMTime() : 0;
+  const unsigned long cellsMTime = cells ? cells->GetMTime() : 0;
+  const bool sameCells =
+      cells == m_preparedCells && cellsMTime == m_preparedCellsMTime;
+  if (points == m_preparedPoints && pointsMTime == m_preparedPointsMTime &&
+      sameCells)
+    {
+    return;
+    }
+
+  m_preparedPoints = points;
+  m_preparedPointsMTime = pointsMTime;
+  m_preparedCells = cells;
+  m_preparedCellsMTime = cellsMTime;
+  m_preparedTime.Modified();
+
+  // Only the points moved (e.g. displacements): keep the cell tables.
+  if (sameCells && points && cells &&
+      points->GetNumberOfPoints() == static_cast<vtkIdType>(m_x.size()))
+    {
+    this->preparePoints(points);
+    this->prepareBounds();
+    return;
+    }
+
+  m_x.clear();
+  m_y.clear();
+  m_z.clear();
+  m_cellIds.clear();
+  m_cellIndex.clear();
+  m_shapes.clear();
+  m_offsets.assign(1, 0);
+  m_connectivity.clear();
+
+  if (!points || !cells)
+    {
+    this->prepareBounds();
+    return;
+    }
+
+  this->preparePoints(points);
+
+  // Cells:
+  const vtkIdType numPoints = points->GetNumberOfPoints();
+  vtkNew<vtkIdList> ids;
+  const vtkIdType numCells = input->GetNumberOfCells();
+  m_cellIndex.assign(numCells, -1);
+  for (vtkIdType cellId = 0; cellId < numCells; ++cellId)
+    {
+    const int shape = shapeOf(input->GetCellType(cellId));
+    if (shape < 0)
+      {
+      continue;
+      }
+
+    input->GetCellPoints(cellId, ids.Get());
+    const int numCorners = Shapes[shape].numberOfCorners;
+    if (ids->GetNumberOfIds() < numCorners)
+      {
+      continue;
+      }
+
+    bool valid = true;
+    for (int c = 0; c < numCorners; ++c)
+      {
+      valid = valid && ids->GetId(c) >= 0 && ids->GetId(c) < numPoints;
+      }
+    if (!valid)
+      {
+      continue;
+      }
+
+    m_connectivity.insert(m_connectivity.end(), ids->GetPointer(0),
+                          ids->GetPointer(0) + numCorners);
+    m_cellIndex[cellId] = static_cast<vtkIdType>(m_cellIds.size());
+    m_cellIds.push_back(cellId);
+    m_shapes.push_back(static_cast<unsigned char>(shape));
+    m_offsets.push_back(static_cast<vtkIdType>(m_connectivity.size()));
+    }
+
+  this->prepareBounds();
+}
+
+//------------------------------------------------------------------------------
+void mvPlaneCutter::preparePoints(vtkPoints *points)
+{
+  const vtkIdType numPoints = points->GetNumberOfPoints();
+  m_x.resize(numPoints);
+  m_y.resize(numPoints);
+  m_z.resize(numPoints);
+  for (vtkIdType i = 0; i < numPoints; ++i)
+    {
+    double p[3];
+    points->GetPoint(i, p);
+    m_x[i] = p[0];
+    m_y[i] = p[1];
+    m_z[i] = p[2];
+    }
+}
+
+//------------------------------------------------------------------------------
+void mvPlaneCutter::prepareBounds()
+{
+  const size_t numCells = m_cellIds.size();
+  m_centerX.resize(numCells);
+  m_centerY.resize(numCells);
+  m_centerZ.resize(numCells);
+  m_extentX.resize(numCells);
+  m_extentY.resize(numCells);
+  m_extentZ.resize(numCells);
+  for (size_t i = 0; i < numCells; ++i)
+    {
+    double bounds[6] = { VTK_DOUBLE_MAX, VTK_DOUBLE_MIN,
+                         VTK_DOUBLE_MAX, VTK_DOUBLE_MIN,
+                         VTK_DOUBLE_MAX, VTK_DOUBLE_MIN };
+    for (vtkIdType c = m_offsets[i]; c < m_offsets[i + 1]; ++c)
+      {
+      const vtkIdType id = m_connectivity[c];
+      bounds[0] = std::min(bounds[0], m_x[id]);
+      bounds[1] = std::max(bounds[1], m_x[id]);
+      bounds[2] = std::min(bounds[2], m_y[id]);
+      bounds[3] = std::max(bounds[3], m_y[id]);
+      bounds[4] = std::min(bounds[4], m_z[id]);
+      bounds[5] = std::max(bounds[5], m_z[id]);
+      }
+
+    m_centerX[i] = 0.5 * (bounds[0] + bounds[1]);
+    m_centerY[i] = 0.5 * (bounds[2] + bounds[3]);
+    m_centerZ[i] = 0.5 * (bounds[4] + bounds[5]);
+    m_extentX[i] = 0.5 * (bounds[1] - bounds[0]);
+    m_extentY[i] = 0.5 * (bounds[3] - bounds[2]);
+    m_extentZ[i] = 0.5 * (bounds[5] - bounds[4]);
+    }
+}
+
+//------------------------------------------------------------------------------
+// The normalized plane and the output of one plane during a cut:
+struct mvPlaneCutter::PlaneState
+{
+  double n[3];
+  double an[3]; // |n|
+  double d;
+  // In-plane basis for ordering the polygon vertices:
+  double u[3];
+  double v[3];
+  // Merges the intersection points of shared edges:
+  std::unordered_map<unsigned long long, vtkIdType> edgeMap;
+  Cut *result;
+};
+
+//------------------------------------------------------------------------------
+void mvPlaneCutter::cut(const double origin[3], const double normal[3],
+                        Cut &result, const mvCellLocator *locator) const
+{
+  std::vector<Plane> planes(1);
+  std::copy(origin, origin + 3, planes[0].origin);
+  std::copy(normal, normal + 3, planes[0].normal);
+
+  std::vector<Cut> results;
+  this->cut(planes, results, locator);
+  result = results[0];
+}
+
+//------------------------------------------------------------------------------
+void mvPlaneCutter::cut(const std::vector<Plane> &planes,
+                        std::vector<Cut> &results,
+                        const mvCellLocator *locator) const
+{
+  results.assign(planes.size(), Cut());
+  std::vector<PlaneState> states;
+  for (size_t k = 0; k < planes.size(); ++k)
+    {
+    Cut &result = results[k];
+    result.meshTime = m_preparedTime.GetMTime();
+    result.points = vtkSmartPointer<vtkPoints>::New();
+    result.lines = vtkSmartPointer<vtkCellArray>::New();
+    result.polys = vtkSmartPointer<vtkCellArray>::New();
+    if (m_preparedPoints)
+      {
+      result.points->SetDataType(m_preparedPoints->GetDataType());
+      }
+
+    PlaneState state;
+    std::copy(planes[k].normal, planes[k].normal + 3, state.n);
+    if (k >= MaxPlanes || vtkMath::Normalize(state.n) == 0.)
+      {
+      continue;
+      }
+    for (int i = 0; i < 3; ++i)
+      {
+      state.an[i] = std::fabs(state.n[i]);
+      }
+    state.d = vtkMath::Dot(state.n, planes[k].origin);
+    vtkMath::Perpendiculars(state.n, state.u, state.v, 0.);
+    state.result = &result;
+    states.push_back(state);
+    }
+
+  const size_t numPlanes = states.size();
+  if (numPlanes == 0)
+    {
+    return;
+    }
+
+  // Find the cells whose bounding box straddles any of the planes, and which
+  // ones, with one pass over the boxes per plane. With a locator, only the
+  // boxes of its candidates are gathered and tested, otherwise all cells are
+  // tested.
+  std::vector<size_t> cells;
+  const double *boxes[6] = { m_centerX.data(), m_centerY.data(),
+                             m_centerZ.data(), m_extentX.data(),
+                             m_extentY.data(), m_extentZ.data() };
+  std::vector<double> gathered[6];
+  if (locator && locator->matches(m_input))
+    {
+    std::vector<vtkIdType> cellIds;
+    for (size_t k = 0; k < numPlanes; ++k)
+      {
+      const PlaneState &p = states[k];
+      const double origin[3] = { p.n[0] * p.d, p.n[1] * p.d, p.n[2] * p.d };
+      locator->findCells(origin, p.n, cellIds);
+      }
+    std::sort(cellIds.begin(), cellIds.end());
+    cellIds.erase(std::unique(cellIds.begin(), cellIds.end()), cellIds.end());
+
+    for (vtkIdType cellId : cellIds)
+      {
+      if (m_cellIndex[cellId] >= 0)
+        {
+        cells.push_back(static_cast<size_t>(m_cellIndex[cellId]));
+        }
+      }
+    for (int b = 0; b < 6; ++b)
+      {
+      gathered[b].resize(cells.size());
+      for (size_t j = 0; j < cells.size(); ++j)
+        {
+        gathered[b][j] = boxes[b][cells[j]];
+        }
+      boxes[b] = gathered[b].data();
+      }
+    }
+  else
+    {
+    cells.resize(m_cellIds.size());
+    for (size_t i = 0; i < cells.size(); ++i)
+      {
+      cells[i] = i;
+      }
+    }
+
+  std::vector<unsigned int> masks(cells.size(), 0);
+  for (size_t k = 0; k < numPlanes; ++k)
+    {
+    const PlaneState &p = states[k];
+    cullBoxes(boxes[0], boxes[1], boxes[2], boxes[3], boxes[4], boxes[5],
+              cells.size(), p.n, p.an, p.d, static_cast<unsigned int>(k),
+              masks.data());
+    }
+
+  // Gather the corners of the candidates once for all planes:
+  std::vector<std::pair<size_t, unsigned int> > candidates;
+  std::vector<size_t> cornerOffsets(1, 0);
+  std::vector<double> cornerX;
+  std::vector<double> cornerY;
+  std::vector<double> cornerZ;
+  for (size_t j = 0; j < cells.size(); ++j)
+    {
+    if (!masks[j])
+      {
+      continue;
+      }
+    const size_t i = cells[j];
+    candidates.push_back(std::make_pair(i, masks[j]));
+    for (vtkIdType c = m_offsets[i]; c < m_offsets[i + 1]; ++c)
+      {
+      const vtkIdType id = m_connectivity[c];
+      cornerX.push_back(m_x[id]);
+      cornerY.push_back(m_y[id]);
+      cornerZ.push_back(m_z[id]);
+      }
+    cornerOffsets.push_back(cornerX.size());
+    }
+
+  // Per plane, evaluate the distances of all gathered corners in one pass,
+  // then cut the cells that straddle it:
+  std::vector<double> dist(cornerX.size());
+  for (size_t k = 0; k < numPlanes; ++k)
+    {
+    PlaneState &p = states[k];
+    planeDistances(cornerX.data(), cornerY.data(), cornerZ.data(),
+                   dist.size(), p.n, p.d, dist.data());
+    for (size_t j = 0; j < candidates.size(); ++j)
+      {
+      if (candidates[j].second & (1u << k))
+        {
+        const size_t offset = cornerOffsets[j];
+        this->cutCell(candidates[j].first, &cornerX[offset],
+                      &cornerY[offset], &cornerZ[offset], &dist[offset], p);
+        }
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void mvPlaneCutter::cutCell(size_t i, const double *x, const double *y,
+                            const double *z, const double *dist,
+                            PlaneState &plane) const
+{
+  const ShapeInfo &shape = Shapes[m_shapes[i]];
+  const vtkIdType *ids = &m_connectivity[m_offsets[i]];
+  Cut &result = *plane.result;
+
+  // Intersect the edges. A corner on the plane is merged as a point of its
+  // own, instead of once for each of its edges that crosses the plane:
+  const unsigned long long numPoints = m_x.size();
+  vtkIdType polygon[12];
+  double position[12][3];
+  int count = 0;
+  for (int e = 0; e < shape.numberOfEdges; ++e)
+    {
+    const int a = shape.edges[e][0];
+    const int b = shape.edges[e][1];
+    if ((dist[a] < 0.) == (dist[b] < 0.))
+      {
+      continue;
+      }
+
+    // Orient the edge by point id, so neighbors produce the same point:
+    int c0 = a;
+    int c1 = b;
+    if (ids[c0] > ids[c1])
+      {
+      std::swap(c0, c1);
+      }
+    vtkIdType p0 = ids[c0];
+    vtkIdType p1 = ids[c1];
+
+    double t = dist[c0] / (dist[c0] - dist[c1]);
+    if (dist[c0] == 0.)
+      {
+      p1 = p0;
+      t = 0.;
+      }
+    else if (dist[c1] == 0.)
+      {
+      p0 = p1;
+      c0 = c1;
+      t = 0.;
+      }
+
+    double *point = position[count];
+    point[0] = x[c0] + t * (x[c1] - x[c0]);
+    point[1] = y[c0] + t * (y[c1] - y[c0]);
+    point[2] = z[c0] + t * (z[c1] - z[c0]);
+
+    const unsigned long long key =
+        static_cast<unsigned long long>(p0) * numPoints +
+        static_cast<unsigned long long>(p1);
+    auto inserted = plane.edgeMap.insert(
+          std::make_pair(key, static_cast<vtkIdType>(result.weights.size())));
+    if (inserted.second)
+      {
+      result.edges.push_back(p0);
+      result.edges.push_back(p1);
+      result.weights.push_back(t);
+      result.points->InsertNextPoint(point);
+      }
+
+    // Several edges of this cell may end in the same corner on the plane:
+    const vtkIdType id = inserted.first->second;
+    if (std::find(polygon, polygon + count, id) == polygon + count)
+      {
+      polygon[count++] = id;
+      }
+    }
+
+  // A 2D cell is cut into a segment. A warped quad may be crossed twice:
+  if (shape.dimension == 2)
+    {
+    for (int k = 0; k + 1 < count; k += 2)
+      {
+      vtkIdType line[2] = { polygon[k], polygon[k + 1] };
+      result.lines->InsertNextCell(2, line);
+      result.lineCells.push_back(m_cellIds[i]);
+      }
+    return;
+    }
+
+  if (count < 3)
+    {
+    return;
+    }
+
+  // The cut through a convex cell is a convex polygon. Sort its vertices by
+  // angle around the centroid and emit a triangle fan:
+  double center[3] = { 0., 0., 0. };
+  for (int k = 0; k < count; ++k)
+    {
+    vtkMath::Add(center, position[k], center);
+    }
+  vtkMath::MultiplyScalar(center, 1. / count);
+
+  double angle[12];
+  int order[12];
+  for (int k = 0; k < count; ++k)
+    {
+    double r[3];
+    vtkMath::Subtract(position[k], center, r);
+    angle[k] = std::atan2(vtkMath::Dot(r, plane.v), vtkMath::Dot(r, plane.u));
+    order[k] = k;
+    }
+  std::sort(order, order + count,
+            [&angle](int l, int r) { return angle[l] < angle[r]; });
+
+  for (int k = 1; k + 1 < count; ++k)
+    {
+    vtkIdType tri[3] = { polygon[order[0]], polygon[order[k]],
+                         polygon[order[k + 1]] };
+    result.polys->InsertNextCell(3, tri);
+    result.cells.push_back(m_cellIds[i]);
+    }
+}
+
+//------------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> mvPlaneCutter::interpolate(const Cut &cut) const
+{
+  vtkSmartPointer<vtkPolyData> output = vtkSmartPointer<vtkPolyData>::New();
+  output->SetPoints(cut.points);
+  output->SetLines(cut.lines);
+  output->SetPolys(cut.polys);
+  if (!m_input)
+    {
+    return output;
+    }
+
+  vtkPointData *inPD = m_input->GetPointData();
+  vtkPointData *outPD = output->GetPointData();
+  const vtkIdType numPoints = static_cast<vtkIdType>(cut.weights.size());
+  outPD->InterpolateAllocate(inPD, numPoints);
+  for (vtkIdType i = 0; i < numPoints; ++i)
+    {
+    outPD->InterpolateEdge(inPD, i, cut.edges[2 * i], cut.edges[2 * i + 1],
+                           cut.weights[i]);
+    }
+
+  // Lines come before polygons in the polydata's cell order:
+  vtkCellData *inCD = m_input->GetCellData();
+  vtkCellData *outCD = output->GetCellData();
+  const vtkIdType numLines = static_cast<vtkIdType>(cut.lineCells.size());
+  const vtkIdType numPolys = static_cast<vtkIdType>(cut.cells.size());
+  outCD->CopyAllocate(inCD, numLines + numPolys);
+  for (vtkIdType i = 0; i < numLines; ++i)
+    {
+    outCD->CopyData(inCD, cut.lineCells[i], i);
+    }
+  for (vtkIdType i = 0; i < numPolys; ++i)
+    {
+    outCD->CopyData(inCD, cut.cells[i], numLines + i);
+    }
+
+  return output;
+}
@@ -0,0 +1,164 @@
+#ifndef MVPLANECUTTER_H
+#define MVPLANECUTTER_H
+
+#include <vtkSmartPointer.h>
+#include <vtkTimeStamp.h>
+#include <vtkType.h>
+
+#include <vector>
+
+class mvCellLocator;
+class vtkCellArray;
+class vtkPoints;
+class vtkPolyData;
+class vtkUnstructuredGrid;
+
+/**
+ * @brief The mvPlaneCutter class cuts an unstructured grid with planes.
+ *
+ * setInput() copies the point coordinates and the bounding box of every cell
+ * into flat structure-of-arrays buffers. A cut first tests the cell bounding
+ * boxes against each plane, optionally restricted to the candidates of an
+ * mvCellLocator. The corners of the cells that straddle a plane are gathered
+ * once, and their signed distances are evaluated per plane. Both passes are
+ * flat loops over the buffers that the compiler can vectorize.
+ * The intersected edges of each such cell are looked up in a per-cell-type
+ * edge table. The resulting convex polygon of a 3D cell is emitted as
+ * triangles, and the cut through a 2D cell as a line segment.
+ * Intersection points on shared edges, and corners lying on the plane, are
+ * merged.
+ *
+ * Linear 3D cells (tetrahedra, hexahedra, voxels, wedges and pyramids) and 2D
+ * cells (triangles, quads and pixels) are supported. Their quadratic variants
+ * are cut through their corner nodes. Other cells are ignored.
+ *
+ * The prepared buffers are reused while the input's points and cells are
+ * unchanged. Datasets assembled from mvArrayCache share these between
+ * timesteps, so the preparation is done once per mesh. When only the points
+ * change (e.g. a displaced mesh), the cell tables are kept and only the
+ * coordinates and cell bounds are refreshed.
+ *
+ * A cut is split into the topology (Cut), which only depends on the mesh and
+ * the plane, and interpolate(), which maps the input's arrays onto it.
+ * While isCurrent() holds for a Cut, it may be kept and re-interpolated for
+ * new arrays on the same mesh, e.g. the next timestep.
+ * cut() and interpolate() are const and may be called concurrently.
+ */
+class mvPlaneCutter
+{
+public:
+  /** Cut planes beyond this number are ignored by cut(). */
+  enum { MaxPlanes = 32 };
+
+  struct Plane
+  {
+    double origin[3];
+    double normal[3];
+  };
+
+  /** The geometry of a cut. */
+  struct Cut
+  {
+    // Two input point ids per output point:
+    std::vector<vtkIdType> edges;
+    // Per output point, the weight of the second point of its edge:
+    std::vector<double> weights;
+    // The input cell of each output triangle:
+    std::vector<vtkIdType> cells;
+    // The input cell of each output line, from 2D cells:
+    std::vector<vtkIdType> lineCells;
+
+    vtkSmartPointer<vtkPoints> points;
+    vtkSmartPointer<vtkCellArray> lines;
+    vtkSmartPointer<vtkCellArray> polys;
+
+    // The preparation of the mesh that was cut:
+    unsigned long meshTime{0};
+  };
+
+  mvPlaneCutter();
+  ~mvPlaneCutter();
+
+  /** Set the grid to cut, preparing the buffers if its mesh changed. @{ */
+  void setInput(vtkUnstructuredGrid *input);
+  vtkUnstructuredGrid* input() const { return m_input; }
+  /** @} */
+
+  /** Returns true if @a cut was computed from the current input's mesh. */
+  bool isCurrent(const Cut &cut) const
+  {
+    return m_preparedPoints && cut.meshTime == m_preparedTime.GetMTime();
+  }
+
+  /**
+   * Cut the input with the plane through @a origin along @a normal. If
+   * @a locator was built for the input's mesh, only its candidate cells are
+   * visited.
+   */
+  void cut(const double origin[3], const double normal[3], Cut &result,
+           const mvCellLocator *locator = nullptr) const;
+
+  /**
+   * Cut the input with several @a planes in a single pass. The culling pass
+   * and the loads of each cell's corners are shared by all planes.
+   * @a results holds one Cut per plane.
+   */
+  void cut(const std::vector<Plane> &planes, std::vector<Cut> &results,
+           const mvCellLocator *locator = nullptr) const;
+
+  /**
+   * Create the output polydata for @a cut. Point arrays are interpolated
+   * along the cut edges, cell arrays are copied from the cut cells.
+   */
+  vtkSmartPointer<vtkPolyData> interpolate(const Cut &cut) const;
+
+private:
+  struct PlaneState;
+
+  // Copy the coordinates of @a points:
+  void preparePoints(vtkPoints *points);
+  // Compute the cell bounds from the coordinates and cell tables:
+  void prepareBounds();
+
+  // Cut supported cell @a i, whose corners are at (@a x, @a y, @a z) with
+  // signed distances @a dist, with @a plane, appending to its result:
+  void cutCell(size_t i, const double *x, const double *y, const double *z,
+               const double *dist, PlaneState &plane) const;
+
+private:
+  // Not implemented -- disable copy:
+  mvPlaneCutter(const mvPlaneCutter&);
+  mvPlaneCutter& operator=(const mvPlaneCutter&);
+
+private:
+  vtkSmartPointer<vtkUnstructuredGrid> m_input;
+  vtkPoints *m_preparedPoints;
+  unsigned long m_preparedPointsMTime;
+  vtkCellArray *m_preparedCells;
+  unsigned long m_preparedCellsMTime;
+  vtkTimeStamp m_preparedTime;
+
+  // Point coordinates:
+  std::vector<double> m_x;
+  std::vector<double> m_y;
+  std::vector<double> m_z;
+
+  // Cell bounding boxes, as center and half extent:
+  std::vector<double> m_centerX;
+  std::vector<double> m_centerY;
+  std::vector<double> m_centerZ;
+  std::vector<double> m_extentX;
+  std::vector<double> m_extentY;
+  std::vector<double> m_extentZ;
+
+  // Supported cells. The corners of cell i are
+  // m_connectivity[m_offsets[i], m_offsets[i + 1]).
+  std::vector<vtkIdType> m_cellIds;
+  // Inverse of m_cellIds, -1 for unsupported cells:
+  std::vector<vtkIdType> m_cellIndex;
+  std::vector<unsigned char> m_shapes;
+  std::vector<vtkIdType> m_offsets;
+  std::vector<vtkIdType> m_connectivity;
+};
+
+#endif // MVPLANECUTTER_H
@@ -0,0 +1,175 @@
+#include "mvRange.h"
+
+#include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkSMPTools.h>
+#include <vtkType.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+long long ChunkSize = 65536;
+
+//------------------------------------------------------------------------------
+// Range of every stride'th value in [data, data + numTuples * stride). Written
+// so that the unit-stride loop vectorizes: the ternaries map onto min/max
+// instructions, which also skip NaNs the same way vtkDataArray::GetRange does.
+template <typename T>
+mvRange::Range minMax(const T *data, vtkIdType numTuples, int stride)
+{
+  T lo = std::numeric_limits<T>::max();
+  T hi = std::numeric_limits<T>::lowest();
+
+  if (stride == 1)
+    {
+    for (vtkIdType i = 0; i < numTuples; ++i)
+      {
+      const T v = data[i];
+      lo = v < lo ? v : lo;
+      hi = v > hi ? v : hi;
+      }
+    }
+  else
+    {
+    for (vtkIdType i = 0; i < numTuples; ++i)
+      {
+      const T v = data[i * stride];
+      lo = v < lo ? v : lo;
+      hi = v > hi ? v : hi;
+      }
+    }
+
+  mvRange::Range result = {{ VTK_DOUBLE_MAX, VTK_DOUBLE_MIN }};
+  if (lo <= hi) // False if there were no (non-NaN) values.
+    {
+    result[0] = static_cast<double>(lo);
+    result[1] = static_cast<double>(hi);
+    }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+// Range of tuples [begin, end) of array's first component.
+mvRange::Range rangeOf(vtkDataArray *array, vtkIdType begin, vtkIdType end)
+{
+  const int stride = array->GetNumberOfComponents();
+  if (vtkFloatArray *fa = vtkFloatArray::SafeDownCast(array))
+    {
+    return minMax(fa->GetPointer(0) + begin * stride, end - begin, stride);
+    }
+  if (vtkDoubleArray *da = vtkDoubleArray::SafeDownCast(array))
+    {
+    return minMax(da->GetPointer(0) + begin * stride, end - begin, stride);
+    }
+
+  // Other types are processed as a single chunk, see compute():
+  mvRange::Range result;
+  array->GetRange(result.data());
+  return result;
+}
+
+//------------------------------------------------------------------------------
+bool isTyped(vtkDataArray *array)
+{
+  return vtkFloatArray::SafeDownCast(array) ||
+      vtkDoubleArray::SafeDownCast(array);
+}
+
+//------------------------------------------------------------------------------
+struct Chunk
+{
+  size_t array;
+  vtkIdType begin;
+  vtkIdType end;
+};
+
+//------------------------------------------------------------------------------
+struct ChunkFunctor
+{
+  const std::vector<vtkDataArray*> &Arrays;
+  const std::vector<Chunk> &Chunks;
+  std::vector<mvRange::Range> &Results;
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType i = begin; i < end; ++i)
+      {
+      const Chunk &chunk = this->Chunks[i];
+      this->Results[i] = rangeOf(this->Arrays[chunk.array], chunk.begin,
+                                 chunk.end);
+      }
+  }
+};
+
+} // end anon namespace
+
+//------------------------------------------------------------------------------
+mvRange::Range mvRange::compute(vtkDataArray *array)
+{
+  Range result = {{ VTK_DOUBLE_MAX, VTK_DOUBLE_MIN }};
+  if (array && array->GetNumberOfTuples() > 0)
+    {
+    result = rangeOf(array, 0, array->GetNumberOfTuples());
+    }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+std::vector<mvRange::Range>
+mvRange::compute(const std::vector<vtkDataArray *> &arrays)
+{
+  // Split the arrays into chunks:
+  const vtkIdType chunkSize = static_cast<vtkIdType>(ChunkSize);
+  std::vector<Chunk> chunks;
+  for (size_t i = 0; i < arrays.size(); ++i)
+    {
+    vtkDataArray *array = arrays[i];
+    if (!array || array->GetNumberOfTuples() == 0)
+      {
+      continue;
+      }
+
+    const vtkIdType numTuples = array->GetNumberOfTuples();
+    if (!isTyped(array))
+      { // GetRange caches its result in the array, so don't split these.
+      chunks.push_back(Chunk{i, 0, numTuples});
+      continue;
+      }
+
+    for (vtkIdType begin = 0; begin < numTuples; begin += chunkSize)
+      {
+      chunks.push_back(Chunk{i, begin, std::min(begin + chunkSize, numTuples)});
+      }
+    }
+
+  std::vector<Range> chunkResults(chunks.size());
+  ChunkFunctor functor = { arrays, chunks, chunkResults };
+  vtkSMPTools::For(0, static_cast<vtkIdType>(chunks.size()), 1, functor);
+
+  // Merge the chunks:
+  std::vector<Range> result(arrays.size(),
+                            Range{{ VTK_DOUBLE_MAX, VTK_DOUBLE_MIN }});
+  for (size_t i = 0; i < chunks.size(); ++i)
+    {
+    Range &r = result[chunks[i].array];
+    r[0] = std::min(r[0], chunkResults[i][0]);
+    r[1] = std::max(r[1], chunkResults[i][1]);
+    }
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+long long mvRange::chunkSize()
+{
+  return ChunkSize;
+}
+
+//------------------------------------------------------------------------------
+void mvRange::setChunkSize(long long tuples)
+{
+  ChunkSize = std::max(1LL, tuples);
+}
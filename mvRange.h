@@ -0,0 +1,48 @@
+#ifndef MVRANGE_H
+#define MVRANGE_H
+
+#include <array>
+#include <vector>
+
+class vtkDataArray;
+
+/**
+ * @brief The mvRange class computes the range of the first component of data
+ * arrays.
+ *
+ * The results match vtkDataArray::GetRange(double[2]): NaN values are ignored
+ * and an empty array produces an inverted range. Float and double arrays use
+ * a typed kernel that the compiler can vectorize; other types defer to
+ * vtkDataArray::GetRange.
+ *
+ * Large arrays are split into chunks so that a single big block still keeps
+ * all threads busy. Work is distributed with vtkSMPTools.
+ */
+class mvRange
+{
+public:
+  using Range = std::array<double, 2>;
+
+  /** Compute the range of @a array's first component. */
+  static Range compute(vtkDataArray *array);
+
+  /**
+   * Compute the ranges of all @a arrays in parallel. The result holds one
+   * range per input array, in the same order. nullptr entries produce an
+   * inverted range.
+   */
+  static std::vector<Range> compute(const std::vector<vtkDataArray*> &arrays);
+
+  /**
+   * The number of tuples processed per task by the parallel compute().
+   * Exposed for benchmarking. @{
+   */
+  static long long chunkSize();
+  static void setChunkSize(long long tuples);
+  /** @} */
+
+private:
+  mvRange(); // Not implemented.
+};
+
+#endif // MVRANGE_H
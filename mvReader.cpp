@@ -1,37 +1,213 @@
 #include "mvReader.h"
 
+#include <vtkCellArray.h>
 #include <vtkCellData.h>
 #include <vtkCompositeDataIterator.h>
 #include <vtkDataArray.h>
 #include <vtkDataSet.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
 #include <vtkImageData.h>
 #include <vtkMultiBlockDataSet.h>
 #include <vtkExodusIIReader.h>
 #include <vtkFieldData.h>
+#include <vtkIdTypeArray.h>
 #include <vtkInformation.h>
 #include <vtkPointData.h>
+#include <vtkPointSet.h>
+#include <vtkPoints.h>
 #include <vtkResampleToImage.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 #include <vtkTimerLog.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkUnstructuredGrid.h>
 
 #include "mvApplicationState.h"
+#include "mvArrayCache.h"
+#include "mvBlockParallel.h"
+#include "mvCellLocator.h"
+#include "mvHistogram.h"
+#include "mvImageCache.h"
+#include "mvRange.h"
+#include "mvSeriesStatistics.h"
+#include "mvTimeStepPrefetcher.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 
+namespace {
+
+//------------------------------------------------------------------------------
+template <typename ArrayT>
+bool sameValues(ArrayT *a, ArrayT *b)
+{
+  if (a == b)
+    {
+    return true;
+    }
+  if (!a || !b || a->GetNumberOfValues() != b->GetNumberOfValues())
+    {
+    return false;
+    }
+  return std::equal(a->GetPointer(0), a->GetPointer(0) + a->GetNumberOfValues(),
+                    b->GetPointer(0));
+}
+
+//------------------------------------------------------------------------------
+// Returns true if @a a and @a b hold the same coordinates.
+bool samePoints(vtkPoints *a, vtkPoints *b)
+{
+  if (a == b)
+    {
+    return true;
+    }
+  if (!a || !b || a->GetDataType() != b->GetDataType() ||
+      a->GetNumberOfPoints() != b->GetNumberOfPoints())
+    {
+    return false;
+    }
+
+  vtkDataArray *da = a->GetData();
+  vtkDataArray *db = b->GetData();
+  if (!da->HasStandardMemoryLayout() || !db->HasStandardMemoryLayout())
+    {
+    return false;
+    }
+  const size_t bytes = static_cast<size_t>(da->GetNumberOfValues()) *
+      static_cast<size_t>(da->GetDataTypeSize());
+  return std::memcmp(da->GetVoidPointer(0), db->GetVoidPointer(0), bytes) == 0;
+}
+
+//------------------------------------------------------------------------------
+// out = reference + scale * disp over flat xyz buffers. A single loop without
+// per-point calls, so the compiler can vectorize it.
+template <typename PointT, typename DispT>
+void displace(const PointT *reference, const DispT *disp, double scale,
+              PointT *out, vtkIdType numValues)
+{
+  for (vtkIdType i = 0; i < numValues; ++i)
+    {
+    out[i] = static_cast<PointT>(reference[i] + scale * disp[i]);
+    }
+}
+
+//------------------------------------------------------------------------------
+template <typename PointT>
+bool displace(const PointT *reference, vtkDataArray *disp, double scale,
+              PointT *out, vtkIdType numValues)
+{
+  if (vtkFloatArray *fa = vtkFloatArray::SafeDownCast(disp))
+    {
+    displace(reference, fa->GetPointer(0), scale, out, numValues);
+    return true;
+    }
+  if (vtkDoubleArray *da = vtkDoubleArray::SafeDownCast(disp))
+    {
+    displace(reference, da->GetPointer(0), scale, out, numValues);
+    return true;
+    }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Displace the xyz tuples of @a reference into @a out, which has the same
+// type and size. Returns false for unsupported array types.
+bool displace(vtkDataArray *reference, vtkDataArray *disp, double scale,
+              vtkDataArray *out)
+{
+  const vtkIdType numValues = 3 * reference->GetNumberOfTuples();
+  if (vtkFloatArray *fa = vtkFloatArray::SafeDownCast(reference))
+    {
+    return displace(fa->GetPointer(0), disp, scale,
+                    vtkFloatArray::SafeDownCast(out)->GetPointer(0),
+                    numValues);
+    }
+  if (vtkDoubleArray *da = vtkDoubleArray::SafeDownCast(reference))
+    {
+    return displace(da->GetPointer(0), disp, scale,
+                    vtkDoubleArray::SafeDownCast(out)->GetPointer(0),
+                    numValues);
+    }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// A copy of the 2-component @a xy with a zero third component, of the same
+// type.
+vtkSmartPointer<vtkDataArray> padToXYZ(vtkDataArray *xy)
+{
+  vtkSmartPointer<vtkDataArray> xyz;
+  xyz.TakeReference(xy->NewInstance());
+  xyz->SetName(xy->GetName());
+  xyz->SetNumberOfComponents(3);
+  xyz->SetNumberOfTuples(xy->GetNumberOfTuples());
+  for (vtkIdType i = 0; i < xy->GetNumberOfTuples(); ++i)
+    {
+    xyz->SetComponent(i, 0, xy->GetComponent(i, 0));
+    xyz->SetComponent(i, 1, xy->GetComponent(i, 1));
+    xyz->SetComponent(i, 2, 0.);
+    }
+  return xyz;
+}
+
+} // end anon namespace
+
 //------------------------------------------------------------------------------
 mvReader::mvReader()
-  : m_numberOfTimeSteps(0),
+  : m_prefetcher(new mvTimeStepPrefetcher),
+    m_arrayCache(new mvArrayCache),
+    m_imageCache(new mvImageCache),
+    m_seriesStats(new mvSeriesStatistics),
+    m_useGlobalRanges(false),
+    m_globalRangesApplied(false),
+    m_globalRangesChanged(false),
+    m_metaDataDirty(false),
+    m_hasDisplacements(false),
+    m_readStaticTopology(false),
+    m_staticTopology(false),
+    m_readTimeStep(0),
+    m_readHistogramBins(256),
+    m_readUseGlobalRanges(false),
+    m_readGlobalRanges(false),
+    m_loadedTimeStep(-1),
+    m_loadedHistogramBins(256),
+    m_cacheBudget(0),
+    m_numberOfTimeSteps(0),
     m_timeStep(0),
     m_timeStepRange{0, 0},
-    m_timeRange{0., 0.}
+    m_timeRange{0., 0.},
+    m_histogramBins(256),
+    m_reducerVoxelBudget(0),
+    m_reducerTimeBudget(0.25),
+    m_reducerVoxels(0.),
+    m_reducerSeconds(0.),
+    m_locatorPending(false),
+    m_locatorRefit(false),
+    m_locatorQuit(false)
 {
+  // Displacements are applied by applyDisplacements(), see fetchData():
+  m_reader->ApplyDisplacementsOff();
   m_reducer->SetSamplingDimensions(64, 64, 64);
+  this->setCacheBudget(static_cast<size_t>(1024) * 1024 * 1024);
 }
 
 //------------------------------------------------------------------------------
 mvReader::~mvReader()
 {
+  if (m_locatorThread.joinable())
+    {
+      {
+      std::lock_guard<std::mutex> lock(m_locatorMutex);
+      m_locatorQuit = true;
+      }
+    m_locatorWake.notify_one();
+    m_locatorThread.join();
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -46,6 +222,135 @@ vtkImageData *mvReader::typedReducedDataObject() const
   return static_cast<vtkImageData*>(m_reducedData.Get());
 }
 
+//------------------------------------------------------------------------------
+int mvReader::prefetchAhead() const
+{
+  return m_prefetcher->stepsAhead();
+}
+
+//------------------------------------------------------------------------------
+void mvReader::setPrefetchAhead(int steps)
+{
+  m_prefetcher->setStepsAhead(steps);
+}
+
+//------------------------------------------------------------------------------
+int mvReader::prefetchBehind() const
+{
+  return m_prefetcher->stepsBehind();
+}
+
+//------------------------------------------------------------------------------
+void mvReader::setPrefetchBehind(int steps)
+{
+  m_prefetcher->setStepsBehind(steps);
+}
+
+//------------------------------------------------------------------------------
+size_t mvReader::cacheBudget() const
+{
+  return m_cacheBudget;
+}
+
+//------------------------------------------------------------------------------
+void mvReader::setCacheBudget(size_t bytes)
+{
+  m_cacheBudget = bytes;
+  const size_t readerBytes = bytes / 4;
+  m_arrayCache->setBudget(bytes - readerBytes);
+
+  // vtkExodusIIReader measures its cache in MiB:
+  std::lock_guard<std::mutex> lock(exodusMutex());
+  m_reader->SetCacheSize(static_cast<double>(readerBytes) / (1024. * 1024.));
+}
+
+//------------------------------------------------------------------------------
+void mvReader::setHistogramBins(int bins)
+{
+  m_histogramBins = std::max(1, bins);
+}
+
+//------------------------------------------------------------------------------
+void mvReader::setReducerVoxelBudget(long long voxels)
+{
+  m_reducerVoxelBudget = std::max(0LL, voxels);
+  m_reducerVoxels = static_cast<double>(m_reducerVoxelBudget);
+  m_reducerSeconds = 0.;
+}
+
+//------------------------------------------------------------------------------
+void mvReader::adaptiveDimensions(const vtkBoundingBox &bounds,
+                                  long long voxels, int dims[3])
+{
+  double lengths[3];
+  bounds.GetLengths(lengths);
+  const double maxLength = bounds.GetMaxLength();
+
+  // Axes that are thin relative to the largest one only get a single sample:
+  double volume = 1.;
+  int numAxes = 0;
+  for (int i = 0; i < 3; ++i)
+    {
+    if (lengths[i] > 1e-3 * maxLength)
+      {
+      volume *= lengths[i];
+      ++numAxes;
+      }
+    }
+
+  if (!bounds.IsValid() || numAxes == 0 || voxels <= 0)
+    {
+    dims[0] = dims[1] = dims[2] = 1;
+    return;
+    }
+
+  // Spacing that yields the requested number of cubic voxels:
+  const double spacing = std::pow(volume / voxels, 1. / numAxes);
+  for (int i = 0; i < 3; ++i)
+    {
+    dims[i] = lengths[i] > 1e-3 * maxLength
+        ? std::max(2, static_cast<int>(std::lround(lengths[i] / spacing)))
+        : 1;
+    }
+}
+
+//------------------------------------------------------------------------------
+mvImageCache::Key mvReader::imageCacheKey() const
+{
+  mvImageCache::Key key;
+  key.fileName = m_loadedFileName;
+  key.timeStep = m_loadedTimeStep;
+  key.variables = m_loadedVariables;
+  return key;
+}
+
+//------------------------------------------------------------------------------
+bool mvReader::updateGlobalRanges()
+{
+  if (m_globalRangesChanged)
+    {
+    m_globalRangesChanged = false;
+    return true;
+    }
+
+  // Rerun the metadata pass once the series statistics become available. The
+  // data itself will be served from m_arrayCache.
+  if (m_useGlobalRanges && !m_globalRangesApplied && m_dataObject &&
+      m_seriesStats->complete())
+    {
+    m_metaDataDirty = true;
+    }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+std::mutex &mvReader::exodusMutex()
+{
+  static std::mutex mutex;
+  return mutex;
+}
+
 //------------------------------------------------------------------------------
 void mvReader::clearRequestedVariables()
 {
@@ -75,41 +380,304 @@ void mvReader::unrequestVariable(const std::string &variable)
 void mvReader::syncReaderState()
 {
   m_reader->SetFileName(m_fileName.c_str());
-  m_reader->SetTimeStep(m_timeStep);
 
-  // Sync variables:
-  const int numPointArrays = m_reader->GetNumberOfPointResultArrays();
-  for (int i = 0; i < numPointArrays; ++i)
-    {
-    std::string array = m_reader->GetPointResultArrayName(i);
-    m_reader->SetPointResultArrayStatus(
-          array.c_str(), this->isVariableRequested(array) ? 1 : 0);
-    }
-  const int numElementArrays = m_reader->GetNumberOfElementResultArrays();
-  for (int i = 0; i < numElementArrays; ++i)
-    {
-    std::string array = m_reader->GetElementResultArrayName(i);
-    m_reader->SetElementResultArrayStatus(
-          array.c_str(), this->isVariableRequested(array) ? 1 : 0);
-    }
+  // Snapshot the request for executeReaderData. The timestep and array
+  // status are applied to m_reader there, since only the variables missing
+  // from m_arrayCache are read.
+  m_readFileName = m_fileName;
+  m_readTimeStep = m_timeStep;
+  m_readVariables = m_requestedVariables;
+  m_readHistogramBins = m_histogramBins;
+  m_readUseGlobalRanges = m_useGlobalRanges;
+
+  // Recenter the prefetch ring:
+  m_prefetcher->request(m_fileName, this->fetchVariables(m_requestedVariables),
+                        m_timeStep, m_timeStepRange);
 }
 
 //------------------------------------------------------------------------------
 bool mvReader::dataNeedsUpdate()
 {
-  return !m_dataObject || m_dataObject->GetMTime() < m_reader->GetMTime();
+  return
+      !m_dataObject ||
+      m_metaDataDirty ||
+      m_loadedFileName != m_fileName ||
+      m_loadedTimeStep != m_timeStep ||
+      m_loadedVariables != m_requestedVariables ||
+      m_loadedHistogramBins != m_histogramBins;
 }
 
 //------------------------------------------------------------------------------
 void mvReader::executeReaderInformation()
 {
+  std::lock_guard<std::mutex> lock(exodusMutex());
   m_reader->UpdateInformation();
 }
 
 //------------------------------------------------------------------------------
 void mvReader::executeReaderData()
 {
+  this->fetchData();
+  if (m_readData)
+    {
+    this->shareTopology();
+    this->applyDisplacements();
+    this->computeMetaData();
+    }
+}
+
+//------------------------------------------------------------------------------
+void mvReader::fetchData()
+{
+  // The mesh is read without displacements, so all timesteps share it. The
+  // displacements are loaded with the variables:
+  const int meshKey = -1;
+  const Variables variables = this->fetchVariables(m_readVariables);
+
+  // Use the prefetched timestep or cached arrays if they are available:
+  m_readData = m_prefetcher->lookup(m_readFileName, m_readTimeStep,
+                                    variables);
+  if (m_readData)
+    {
+    m_arrayCache->store(meshKey, m_readTimeStep, m_readData, variables);
+    return;
+    }
+
+  m_readData = m_arrayCache->assemble(meshKey, m_readTimeStep, variables);
+  if (m_readData)
+    {
+    return;
+    }
+
+  // Only read the variables that aren't cached. When the mesh is cached, the
+  // new arrays are merged into it and the mesh in the reader's output is
+  // discarded.
+  Variables toRead = m_arrayCache->missing(meshKey, m_readTimeStep,
+                                           variables);
+  vtkSmartPointer<vtkMultiBlockDataSet> read =
+      this->readTimeStep(m_readTimeStep, toRead);
+  m_arrayCache->store(meshKey, m_readTimeStep, read, toRead);
+
+  if (toRead != variables)
+    {
+    m_readData = m_arrayCache->assemble(meshKey, m_readTimeStep,
+                                        variables);
+    }
+
+  // Fall back to reading everything if the partial read couldn't be merged,
+  // e.g. because the cache evicted an entry in the meantime:
+  if (!m_readData)
+    {
+    m_readData = toRead == variables
+        ? read : this->readTimeStep(m_readTimeStep, variables);
+    }
+}
+
+//------------------------------------------------------------------------------
+mvReader::Variables mvReader::fetchVariables(const Variables &variables) const
+{
+  Variables result(variables);
+  if (m_hasDisplacements)
+    {
+    result.insert(m_displacementArray);
+    }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+void mvReader::shareTopology()
+{
+  // Compare the connectivity of each block with the previous timestep. The
+  // arrays are usually already shared through m_arrayCache, otherwise (e.g.
+  // prefetched timesteps, or reads that bypass the cache) their contents are
+  // compared. The undisplaced points are shared the same way, so that the
+  // caches keyed on the vtkPoints (mvPlaneCutter, mvCellLocator) stay valid
+  // across timesteps read from the file.
+  std::vector<Topology> topology;
+  std::vector<vtkSmartPointer<vtkDataSet> > replacements;
+  bool staticTopology = !m_readTopology.empty();
+
+  vtkCompositeDataIterator *it = m_readData->NewIterator();
+  for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+    {
+    const size_t leaf = topology.size();
+    vtkUnstructuredGrid *grid =
+        vtkUnstructuredGrid::SafeDownCast(it->GetCurrentDataObject());
+    replacements.push_back(nullptr);
+    topology.push_back(Topology());
+    if (!grid)
+      {
+      staticTopology = staticTopology && leaf < m_readTopology.size() &&
+          !m_readTopology[leaf].cells;
+      continue;
+      }
+
+    Topology &current = topology.back();
+    current.types = grid->GetCellTypesArray();
+    current.locations = grid->GetCellLocationsArray();
+    current.cells = grid->GetCells();
+    current.points = grid->GetPoints();
+
+    const Topology *previous =
+        leaf < m_readTopology.size() ? &m_readTopology[leaf] : nullptr;
+    if (!previous || !previous->cells || !current.cells ||
+        !sameValues(current.types.Get(), previous->types.Get()) ||
+        !sameValues(current.cells->GetData(), previous->cells->GetData()))
+      {
+      staticTopology = false;
+      continue;
+      }
+
+    const bool shareCells =
+        current.cells != previous->cells || current.types != previous->types;
+    const bool sharePoints =
+        current.points != previous->points &&
+        samePoints(current.points, previous->points);
+    if (shareCells || sharePoints)
+      {
+      vtkSmartPointer<vtkUnstructuredGrid> shared =
+          vtkSmartPointer<vtkUnstructuredGrid>::New();
+      shared->ShallowCopy(grid);
+      if (shareCells)
+        {
+        shared->SetCells(previous->types, previous->locations, previous->cells);
+        current.types = previous->types;
+        current.locations = previous->locations;
+        current.cells = previous->cells;
+        }
+      if (sharePoints)
+        {
+        shared->SetPoints(previous->points);
+        current.points = previous->points;
+        }
+      replacements.back() = shared;
+      }
+    }
+  it->Delete();
+
+  staticTopology = staticTopology && topology.size() == m_readTopology.size();
+  m_readTopology.swap(topology);
+  m_readStaticTopology = staticTopology;
+
+  this->replaceBlocks(replacements);
+}
+
+//------------------------------------------------------------------------------
+void mvReader::applyDisplacements()
+{
+  if (!m_hasDisplacements)
+    {
+    return;
+    }
+
+  // The mesh was read without displacements, so that it is shared by all
+  // timesteps. Displace copies of its blocks:
+  const double scale = m_reader->GetDisplacementMagnitude();
+  std::vector<vtkSmartPointer<vtkDataSet> > displaced;
+  vtkCompositeDataIterator *it = m_readData->NewIterator();
+  for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+    {
+    displaced.push_back(nullptr);
+    vtkPointSet *ps = vtkPointSet::SafeDownCast(it->GetCurrentDataObject());
+    vtkPoints *reference = ps ? ps->GetPoints() : nullptr;
+    vtkDataArray *disp = ps ? ps->GetPointData()->GetArray(
+                                m_displacementArray.c_str()) : nullptr;
+    if (!reference || !disp ||
+        disp->GetNumberOfTuples() != reference->GetNumberOfPoints())
+      {
+      continue;
+      }
+
+    // 2-D meshes have xy displacements:
+    vtkSmartPointer<vtkDataArray> padded;
+    if (disp->GetNumberOfComponents() == 2)
+      {
+      padded = padToXYZ(disp);
+      disp = padded;
+      }
+    if (disp->GetNumberOfComponents() != 3)
+      {
+      continue;
+      }
+
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetDataType(reference->GetDataType());
+    points->SetNumberOfPoints(reference->GetNumberOfPoints());
+    if (!displace(reference->GetData(), disp, scale, points->GetData()))
+      {
+      continue;
+      }
+
+    vtkSmartPointer<vtkPointSet> copy;
+    copy.TakeReference(ps->NewInstance());
+    copy->ShallowCopy(ps);
+    copy->SetPoints(points);
+    displaced.back() = copy;
+    }
+  it->Delete();
+
+  this->replaceBlocks(displaced);
+}
+
+//------------------------------------------------------------------------------
+void mvReader::replaceBlocks(
+    const std::vector<vtkSmartPointer<vtkDataSet> > &blocks)
+{
+  if (std::none_of(blocks.begin(), blocks.end(),
+                   [](const vtkSmartPointer<vtkDataSet> &ds)
+                     { return ds.Get() != nullptr; }))
+    {
+    return;
+    }
+
+  // Swap the blocks into a copy, m_readData may be cached elsewhere:
+  vtkSmartPointer<vtkMultiBlockDataSet> result;
+  result.TakeReference(m_readData->NewInstance());
+  result->ShallowCopy(m_readData);
+  size_t leaf = 0;
+  vtkCompositeDataIterator *it = result->NewIterator();
+  for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+    {
+    if (leaf < blocks.size() && blocks[leaf])
+      {
+      result->SetDataSet(it, blocks[leaf]);
+      }
+    ++leaf;
+    }
+  it->Delete();
+  m_readData = result;
+}
+
+//------------------------------------------------------------------------------
+vtkSmartPointer<vtkMultiBlockDataSet>
+mvReader::readTimeStep(int timeStep, const Variables &variables)
+{
+  std::lock_guard<std::mutex> lock(exodusMutex());
+
+  m_reader->SetTimeStep(timeStep);
+
+  const int numPointArrays = m_reader->GetNumberOfPointResultArrays();
+  for (int i = 0; i < numPointArrays; ++i)
+    {
+    std::string array = m_reader->GetPointResultArrayName(i);
+    m_reader->SetPointResultArrayStatus(
+          array.c_str(), variables.find(array) != variables.end() ? 1 : 0);
+    }
+  const int numElementArrays = m_reader->GetNumberOfElementResultArrays();
+  for (int i = 0; i < numElementArrays; ++i)
+    {
+    std::string array = m_reader->GetElementResultArrayName(i);
+    m_reader->SetElementResultArrayStatus(
+          array.c_str(), variables.find(array) != variables.end() ? 1 : 0);
+    }
+
   m_reader->Update();
+
+  vtkMultiBlockDataSet *output = m_reader->GetOutput();
+  vtkSmartPointer<vtkMultiBlockDataSet> result;
+  result.TakeReference(output->NewInstance());
+  result->ShallowCopy(output);
+  return result;
 }
 
 //------------------------------------------------------------------------------
@@ -122,34 +690,192 @@ void mvReader::updateInformationCache()
 
   // Set available arrays:
   m_availableVariables.clear();
+  m_hasDisplacements = false;
+  m_displacementArray.clear();
+  const int dimension = m_reader->GetDimensionality();
   const int numPointArrays = m_reader->GetNumberOfPointResultArrays();
   for (int i = 0; i < numPointArrays; ++i)
     {
-    m_availableVariables.insert(m_reader->GetPointResultArrayName(i));
+    std::string array = m_reader->GetPointResultArrayName(i);
+
+    // Same test that vtkExodusIIReader uses to find displacement vectors: the
+    // first "dis*" array with a component per spatial dimension. Scalars such
+    // as "dissipation" are skipped.
+    if (!m_hasDisplacements && array.size() >= 3 &&
+        std::tolower(array[0]) == 'd' && std::tolower(array[1]) == 'i' &&
+        std::tolower(array[2]) == 's' &&
+        m_reader->GetNumberOfObjectArrayComponents(
+          vtkExodusIIReader::NODAL, i) == dimension)
+      {
+      m_hasDisplacements = true;
+      m_displacementArray = array;
+      }
+
+    m_availableVariables.insert(array);
     }
   const int numElementArrays = m_reader->GetNumberOfElementResultArrays();
   for (int i = 0; i < numElementArrays; ++i)
     {
     m_availableVariables.insert(m_reader->GetElementResultArrayName(i));
     }
+
+  // Cached data belongs to the previous file:
+  m_arrayCache->clear();
+  m_imageCache->clear();
+  m_readTopology.clear();
+
+  if (m_useGlobalRanges)
+    {
+    m_seriesStats->start(m_fileName);
+    }
 }
 
 //------------------------------------------------------------------------------
 void mvReader::updateDataCache()
 {
   // Copy data object:
-  vtkMultiBlockDataSet *mbds = m_reader->GetOutput();
+  vtkMultiBlockDataSet *mbds = m_readData.Get();
   m_dataObject.TakeReference(mbds->NewInstance());
   m_dataObject->ShallowCopy(mbds);
+  m_readData = nullptr;
+
+  // Metadata was computed by executeReaderData:
+  m_variableMap.swap(m_readVariableMap);
+  m_readVariableMap.clear();
+  m_bounds = m_readBounds;
+  m_staticTopology = m_readStaticTopology;
+
+  if (m_readGlobalRanges && !m_globalRangesApplied)
+    {
+    m_globalRangesChanged = true;
+    }
+  m_globalRangesApplied = m_readGlobalRanges;
+
+  m_loadedFileName = m_readFileName;
+  m_loadedTimeStep = m_readTimeStep;
+  m_loadedVariables = m_readVariables;
+  m_loadedHistogramBins = m_readHistogramBins;
+  m_metaDataDirty = false;
+
+  this->updateCellLocators();
+}
 
-  // Collect metadata next:
+//------------------------------------------------------------------------------
+mvReader::CellLocators mvReader::cellLocators() const
+{
+  std::lock_guard<std::mutex> lock(m_locatorMutex);
+  return m_cellLocators;
+}
+
+//------------------------------------------------------------------------------
+void mvReader::updateCellLocators()
+{
+  // The mesh is identified by the cells and undisplaced points of each block,
+  // which datasets assembled from m_arrayCache share between timesteps. The
+  // displaced points change with every timestep, the locators of the mesh
+  // are then only refit to them.
+  std::vector<vtkSmartPointer<vtkUnstructuredGrid> > grids;
+  std::vector<unsigned long long> mesh;
+  std::vector<unsigned long long> points;
+  size_t leaf = 0;
+  for (vtkDataSet *ds : mvBlockParallel::blocks(m_dataObject))
+    {
+    vtkUnstructuredGrid *grid = vtkUnstructuredGrid::SafeDownCast(ds);
+    vtkPoints *current = grid ? grid->GetPoints() : nullptr;
+    vtkPoints *reference = current;
+    if (m_hasDisplacements && leaf < m_readTopology.size() &&
+        m_readTopology[leaf].points)
+      {
+      reference = m_readTopology[leaf].points;
+      }
+    ++leaf;
+    vtkCellArray *cells = grid ? grid->GetCells() : nullptr;
+    mesh.push_back(reinterpret_cast<uintptr_t>(reference));
+    mesh.push_back(reference ? reference->GetMTime() : 0);
+    mesh.push_back(reinterpret_cast<uintptr_t>(cells));
+    mesh.push_back(cells ? cells->GetMTime() : 0);
+    points.push_back(reinterpret_cast<uintptr_t>(current));
+    points.push_back(current ? current->GetMTime() : 0);
+    grids.push_back(grid);
+    }
+
+  const bool sameMesh = mesh == m_locatorMesh;
+  if (sameMesh && points == m_locatorPoints)
+    {
+    return;
+    }
+  m_locatorMesh.swap(mesh);
+  m_locatorPoints.swap(points);
+
+  // Hand the mesh to the worker without waiting for a build in progress. It
+  // replaces any request that was not picked up yet.
+    {
+    std::lock_guard<std::mutex> lock(m_locatorMutex);
+    m_locatorGrids.swap(grids);
+    // A pending full build must not be downgraded to a refit:
+    m_locatorRefit = sameMesh && (m_locatorRefit || !m_locatorPending);
+    m_locatorPending = true;
+    }
+  if (!m_locatorThread.joinable())
+    {
+    m_locatorThread = std::thread(&mvReader::buildCellLocators, this);
+    }
+  m_locatorWake.notify_one();
+}
+
+//------------------------------------------------------------------------------
+void mvReader::buildCellLocators()
+{
+  std::unique_lock<std::mutex> lock(m_locatorMutex);
+  while (!m_locatorQuit)
+    {
+    if (!m_locatorPending)
+      {
+      m_locatorWake.wait(lock);
+      continue;
+      }
+
+    std::vector<vtkSmartPointer<vtkUnstructuredGrid> > grids;
+    grids.swap(m_locatorGrids);
+    const CellLocators previous =
+        m_locatorRefit ? m_cellLocators : CellLocators();
+    m_locatorPending = false;
+    lock.unlock();
 
+    CellLocators locators(grids.size());
+    mvBlockParallel::forEach(grids.size(), [&](size_t i)
+      {
+      if (grids[i])
+        {
+        std::shared_ptr<mvCellLocator> locator(new mvCellLocator);
+        if (i >= previous.size() || !previous[i] ||
+            !locator->refit(*previous[i], grids[i]))
+          {
+          locator->build(grids[i]);
+          }
+        locators[i] = locator;
+        }
+      });
+
+    lock.lock();
+    m_cellLocators.swap(locators);
+    }
+}
+
+//------------------------------------------------------------------------------
+void mvReader::computeMetaData()
+{
   // Reset state:
-  m_bounds.Reset();
-  m_variableMap.clear();
+  m_readBounds.Reset();
+  m_readVariableMap.clear();
 
-  // Helper lambda to update m_variableMap with the arrays in fd.
-  auto mergeMetaData = [&](VariableMetaData::Location loc, vtkFieldData *fd)
+  // Gather the arrays of every block so that their ranges can be computed in
+  // parallel. The displacements are always loaded, but only reported if they
+  // were requested:
+  const bool skipDisplacements = m_hasDisplacements &&
+      m_readVariables.find(m_displacementArray) == m_readVariables.end();
+  std::vector<std::pair<VariableMetaData::Location, vtkDataArray*> > arrays;
+  auto gatherArrays = [&](VariableMetaData::Location loc, vtkFieldData *fd)
   {
     const int size = fd->GetNumberOfArrays();
     for (int i = 0; i < size; ++i)
@@ -159,51 +885,142 @@ void mvReader::updateDataCache()
         {
         continue;
         }
-      std::string name = array->GetName() ? array->GetName() : "";
-      auto iter = m_variableMap.find(name);
-      if (iter == m_variableMap.end())
-        { // New metadata
-        auto r = m_variableMap.insert(std::make_pair(name,
-                                                     VariableMetaData(loc)));
-        iter = r.first;
-        }
-      VariableMetaData &metaData = iter->second;
-
-      // Sanity check:
-      if (metaData.location != loc)
-        { // Shouldn't happen, but just warn and continue on.
-        std::cerr << "Field data location mismatch for array: " << name << "\n";
+      if (skipDisplacements && array->GetName() &&
+          m_displacementArray == array->GetName())
+        {
+        continue;
         }
-
-      // Merge the ranges:
-      double range[2];
-      array->GetRange(range);
-      metaData.range[0] = std::min(range[0], metaData.range[0]);
-      metaData.range[1] = std::max(range[1], metaData.range[1]);
+      arrays.push_back(std::make_pair(loc, array));
       }
   };
 
   // Process datasets:
-  vtkCompositeDataIterator *i = this->typedDataObject()->NewIterator();
+  vtkCompositeDataIterator *i = m_readData->NewIterator();
   for (i->InitTraversal(); !i->IsDoneWithTraversal(); i->GoToNextItem())
     {
     if (vtkDataSet *ds = vtkDataSet::SafeDownCast(i->GetCurrentDataObject()))
       {
-      mergeMetaData(VariableMetaData::Location::FieldData, ds->GetFieldData());
-      mergeMetaData(VariableMetaData::Location::PointData, ds->GetPointData());
-      mergeMetaData(VariableMetaData::Location::CellData,  ds->GetCellData());
+      gatherArrays(VariableMetaData::Location::FieldData, ds->GetFieldData());
+      gatherArrays(VariableMetaData::Location::PointData, ds->GetPointData());
+      gatherArrays(VariableMetaData::Location::CellData,  ds->GetCellData());
       double b[6];
       ds->GetBounds(b);
-      m_bounds.AddBounds(b);
+      m_readBounds.AddBounds(b);
       }
     }
   i->Delete();
+
+  std::vector<vtkDataArray*> rangeArrays;
+  rangeArrays.reserve(arrays.size());
+  for (const auto &a : arrays)
+    {
+    rangeArrays.push_back(a.second);
+    }
+  const std::vector<mvRange::Range> ranges = mvRange::compute(rangeArrays);
+
+  // Update m_readVariableMap:
+  std::map<std::string, std::vector<vtkDataArray*> > variableArrays;
+  for (size_t a = 0; a < arrays.size(); ++a)
+    {
+    const VariableMetaData::Location loc = arrays[a].first;
+    vtkDataArray *array = arrays[a].second;
+    std::string name = array->GetName() ? array->GetName() : "";
+    auto iter = m_readVariableMap.find(name);
+    if (iter == m_readVariableMap.end())
+      { // New metadata
+      auto r = m_readVariableMap.insert(std::make_pair(name,
+                                                       VariableMetaData(loc)));
+      iter = r.first;
+      }
+    VariableMetaData &metaData = iter->second;
+
+    // Sanity check:
+    if (metaData.location != loc)
+      { // Shouldn't happen, but just warn and continue on.
+      std::cerr << "Field data location mismatch for array: " << name << "\n";
+      }
+
+    // Merge the ranges:
+    metaData.range[0] = std::min(ranges[a][0], metaData.range[0]);
+    metaData.range[1] = std::max(ranges[a][1], metaData.range[1]);
+
+    variableArrays[name].push_back(array);
+    }
+
+  // Substitute the whole-series ranges:
+  m_readGlobalRanges = m_readUseGlobalRanges && m_seriesStats->complete();
+  if (m_readGlobalRanges)
+    {
+    mvSeriesStatistics::Variable stats;
+    for (auto &var : m_readVariableMap)
+      {
+      if (m_seriesStats->lookup(var.first, stats))
+        {
+        var.second.range[0] = stats.range[0];
+        var.second.range[1] = stats.range[1];
+        }
+      }
+    }
+
+  // Histograms, while the arrays are still hot in cache:
+  for (auto &var : m_readVariableMap)
+    {
+    VariableMetaData &metaData = var.second;
+    metaData.histogram = mvHistogram::compute(variableArrays[var.first],
+                                              metaData.range,
+                                              m_readHistogramBins);
+    }
 }
 
 //------------------------------------------------------------------------------
 void mvReader::syncReducerState()
 {
+  const bool newInput =
+      m_reducer->GetInputDataObject(0, 0) != m_dataObject.Get();
   m_reducer->SetInputDataObject(m_dataObject.Get());
+
+  if (m_reducerVoxelBudget <= 0)
+    {
+    m_reducer->SetSamplingDimensions(64, 64, 64);
+    }
+  else if (newInput)
+    {
+    // Only adapt the resolution when new data arrives, otherwise the change in
+    // dimensions would retrigger the reducer.
+    this->adaptReducerDimensions();
+    }
+
+  m_reducerKey = this->imageCacheKey();
+  m_reducer->GetSamplingDimensions(m_reducerKey.dimensions);
+}
+
+//------------------------------------------------------------------------------
+void mvReader::adaptReducerDimensions()
+{
+  // Scale the voxel count towards the time budget. The reducer's cost is
+  // roughly linear in the number of voxels. Small deviations are ignored and
+  // the step is limited to avoid oscillating on noisy timings.
+  if (m_reducerTimeBudget > 0. && m_reducerSeconds > 0.)
+    {
+    const double ratio = m_reducerTimeBudget / m_reducerSeconds;
+    if (ratio < 0.8 || ratio > 1.25)
+      {
+      const double scale = std::max(0.5, std::min(2., ratio));
+      m_reducerVoxels = std::max(4096., std::min(
+                                   static_cast<double>(m_reducerVoxelBudget),
+                                   m_reducerVoxels * scale));
+      }
+    m_reducerSeconds = 0.;
+    }
+
+  int dims[3];
+  this->adaptiveDimensions(m_bounds,
+                           static_cast<long long>(m_reducerVoxels), dims);
+  int *current = m_reducer->GetSamplingDimensions();
+  if (dims[0] != current[0] || dims[1] != current[1] || dims[2] != current[2])
+    {
+    m_reducer->SetSamplingDimensions(dims);
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -218,13 +1035,25 @@ bool mvReader::reducerNeedsUpdate()
 //------------------------------------------------------------------------------
 void mvReader::executeReducer()
 {
+  m_reducedResult = m_imageCache->find(m_reducerKey);
+  if (m_reducedResult)
+    {
+    return;
+    }
+
+  const double start = vtkTimerLog::GetUniversalTime();
   m_reducer->Update();
+  m_reducerSeconds = vtkTimerLog::GetUniversalTime() - start;
+
+  m_reducedResult = m_reducer->GetOutputDataObject(0);
+  m_imageCache->store(m_reducerKey, m_reducedResult);
 }
 
 //------------------------------------------------------------------------------
 void mvReader::updateReducedData()
 {
-  vtkDataObject *output = m_reducer->GetOutputDataObject(0);
+  vtkDataObject *output = m_reducedResult.Get();
   m_reducedData.TakeReference(output->NewInstance());
   m_reducedData->ShallowCopy(output);
+  m_reducedResult = nullptr;
 }
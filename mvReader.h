@@ -7,15 +7,32 @@
 
 #include <vvReader.h>
 
+#include "mvImageCache.h"
+
+#include <condition_variable>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <limits>
+#include <thread>
 #include <vector>
 
+class mvArrayCache;
+class mvCellLocator;
+class mvSeriesStatistics;
+class mvTimeStepPrefetcher;
+class vtkCellArray;
 class vtkExodusIIReader;
+class vtkDataObject;
+class vtkDataSet;
+class vtkIdTypeArray;
 class vtkImageData;
 class vtkMultiBlockDataSet;
+class vtkPoints;
 class vtkResampleToImage;
+class vtkUnsignedCharArray;
+class vtkUnstructuredGrid;
 
 /**
  * @brief The mvReader class manages loading the current dataset from a
@@ -121,6 +138,131 @@ public:
   void timeRange(double r[2]);
   /** @} */
 
+  /**
+   * The number of timesteps that are decoded in the background ahead of and
+   * behind the current timestep. Stepping onto a prefetched timestep skips
+   * the file read entirely. Both default to 0 (no prefetching). @{
+   */
+  int prefetchAhead() const;
+  void setPrefetchAhead(int steps);
+  int prefetchBehind() const;
+  void setPrefetchBehind(int steps);
+  /** @} */
+
+  /**
+   * Memory-budgeted cache of decoded variables. Revisiting a timestep or
+   * re-requesting a variable is served from here when possible. Use this to
+   * adjust the budget and inspect the hit/miss/eviction counters. @{
+   */
+  mvArrayCache& arrayCache() { return *m_arrayCache; }
+  const mvArrayCache& arrayCache() const { return *m_arrayCache; }
+  /** @} */
+
+  /**
+   * Memory-budgeted cache of resampled images, shared by the reducer and
+   * mvVolume. Use imageCacheKey() to build keys for the current
+   * dataObject(). @{
+   */
+  mvImageCache& imageCache() const { return *m_imageCache; }
+  mvImageCache::Key imageCacheKey() const;
+  /** @} */
+
+  /**
+   * The memory budget in bytes shared by the arrayCache() and the Exodus
+   * reader's internal cache. A quarter goes to the reader, which keeps the
+   * mesh coordinates and connectivity resident between partial reads. @{
+   */
+  size_t cacheBudget() const;
+  void setCacheBudget(size_t bytes);
+  /** @} */
+
+  /**
+   * If true, the ranges in variableMetaData() span the entire time series
+   * instead of the current timestep, so that color mapping stays stable
+   * during animation. The whole-series statistics are computed in the
+   * background the first time a file is opened and are cached in a sidecar
+   * file next to it (see mvSeriesStatistics). Until they are available, the
+   * per-timestep ranges are reported. Off by default. @{
+   */
+  bool useGlobalRanges() const { return m_useGlobalRanges; }
+  void setUseGlobalRanges(bool use) { m_useGlobalRanges = use; }
+  /** @} */
+
+  /** The whole-series statistics. See useGlobalRanges(). */
+  const mvSeriesStatistics& seriesStatistics() const { return *m_seriesStats; }
+
+  /**
+   * Pick up newly available whole-series ranges. Call this after update().
+   * Returns true if the ranges in variableMetaData() changed since the last
+   * call.
+   */
+  bool updateGlobalRanges();
+
+  /**
+   * True if the ranges in variableMetaData() are the whole-series ranges.
+   * The histograms of seriesStatistics() then span them as well.
+   */
+  bool globalRangesApplied() const { return m_globalRangesApplied; }
+
+  /**
+   * The number of bins in VariableMetaData::histogram. Default is 256. @{
+   */
+  int histogramBins() const { return m_histogramBins; }
+  void setHistogramBins(int bins);
+  /** @} */
+
+  /**
+   * Sampling resolution of reducedDataObject(). If the voxel budget is 0
+   * (the default), a fixed 64x64x64 grid is used. Otherwise the dimensions
+   * follow the aspect ratio of the dataset bounds so that about that many
+   * voxels are sampled. Each voxel costs roughly 4-8 bytes per point
+   * variable.
+   *
+   * In adaptive mode the budget is additionally scaled after each resample
+   * to keep the reducer within the time budget (in seconds), so the LoRes
+   * preview stays interactive on any input. A time budget <= 0 disables this.
+   * @{
+   */
+  long long reducerVoxelBudget() const { return m_reducerVoxelBudget; }
+  void setReducerVoxelBudget(long long voxels);
+  double reducerTimeBudget() const { return m_reducerTimeBudget; }
+  void setReducerTimeBudget(double seconds) { m_reducerTimeBudget = seconds; }
+  /** @} */
+
+  /**
+   * Spatial locators for the blocks of dataObject(), in the traversal order
+   * of mvBlockParallel::blocks(). They are built in the background the first
+   * time a mesh is loaded and are reused for all timesteps sharing it. For
+   * displaced timesteps, the locators of the undisplaced mesh are refit. The
+   * result is empty until the build completes, and entries are nullptr for
+   * blocks that are not unstructured grids. Check mvCellLocator::matches()
+   * before using an entry.
+   */
+  using CellLocators = std::vector<std::shared_ptr<const mvCellLocator> >;
+  CellLocators cellLocators() const;
+
+  /**
+   * True if the connectivity of dataObject() is the same as for the previously
+   * loaded timestep. Unchanged blocks then share the cell arrays of the
+   * previous timestep, so filters that only depend on the connectivity (e.g.
+   * surface extraction) can detect this by the identity of vtkCellArray.
+   */
+  bool staticTopology() const { return m_staticTopology; }
+
+  /**
+   * Compute sampling dimensions for @a bounds that have about @a voxels
+   * samples with equal spacing along each axis. Flat axes get a single
+   * sample.
+   */
+  static void adaptiveDimensions(const vtkBoundingBox &bounds,
+                                 long long voxels, int dims[3]);
+
+  /**
+   * Serializes access to Exodus II files. The netCDF library is not
+   * thread-safe, so all readers must hold this while touching a file.
+   */
+  static std::mutex& exodusMutex();
+
 private:
   void syncReaderState() override;
   bool dataNeedsUpdate() override;
@@ -134,19 +276,129 @@ private:
   void executeReducer() override;
   void updateReducedData() override;
 
+  // Pick the reducer's sampling dimensions in adaptive mode:
+  void adaptReducerDimensions();
+
+  // Request new m_cellLocators if the mesh of m_dataObject changed:
+  void updateCellLocators();
+
+  // Body of m_locatorThread, builds the locators of the latest request:
+  void buildCellLocators();
+
+  // Fill m_readData from the prefetcher, m_arrayCache, or the file:
+  void fetchData();
+
+  // @a variables, plus the displacements if the file has them:
+  Variables fetchVariables(const Variables &variables) const;
+
+  // Make the blocks of m_readData share the cell arrays of the previous
+  // timestep when their connectivity is unchanged, see staticTopology():
+  void shareTopology();
+
+  // Displace the points of m_readData's blocks, see m_hasDisplacements:
+  void applyDisplacements();
+
+  // Replace the non-null @a blocks of m_readData, in traversal order:
+  void replaceBlocks(const std::vector<vtkSmartPointer<vtkDataSet> > &blocks);
+
+  // Compute m_readVariableMap and m_readBounds for m_readData. Runs on the
+  // background thread so the main thread only swaps the results in.
+  void computeMetaData();
+
+  // Read @a variables for @a timeStep with m_reader. Thread-safe with respect
+  // to other Exodus readers.
+  vtkSmartPointer<vtkMultiBlockDataSet> readTimeStep(
+      int timeStep, const Variables &variables);
+
 private:
   vtkNew<vtkExodusIIReader> m_reader;
   VariableMetaDataMap m_variableMap;
 
   vtkNew<vtkResampleToImage> m_reducer;
 
+  std::unique_ptr<mvTimeStepPrefetcher> m_prefetcher;
+  std::unique_ptr<mvArrayCache> m_arrayCache;
+  std::unique_ptr<mvImageCache> m_imageCache;
+  std::unique_ptr<mvSeriesStatistics> m_seriesStats;
+  bool m_useGlobalRanges;
+  // True if the ranges in m_variableMap are the whole-series ranges:
+  bool m_globalRangesApplied;
+  // Set when m_globalRangesApplied becomes true, see updateGlobalRanges():
+  bool m_globalRangesChanged;
+  // Forces a reread so the metadata pass picks up the whole-series ranges:
+  bool m_metaDataDirty;
+  // The dataset produced by executeReaderData, consumed by updateDataCache:
+  vtkSmartPointer<vtkMultiBlockDataSet> m_readData;
+  // True if the file has displacement variables. The mesh is then read
+  // undisplaced and shared in m_arrayCache like any other mesh. The
+  // displacement array is always loaded, and applied to each timestep by
+  // applyDisplacements(). It is only reported in variableMetaData() if it
+  // was requested.
+  bool m_hasDisplacements;
+  std::string m_displacementArray;
+  // The connectivity of each block of the last m_readData:
+  struct Topology
+  {
+    vtkSmartPointer<vtkUnsignedCharArray> types;
+    vtkSmartPointer<vtkIdTypeArray> locations;
+    vtkSmartPointer<vtkCellArray> cells;
+    vtkSmartPointer<vtkPoints> points; // Undisplaced.
+  };
+  std::vector<Topology> m_readTopology;
+  bool m_readStaticTopology;
+  bool m_staticTopology;
+  // The request being read by executeReaderData, and its results:
+  std::string m_readFileName;
+  int m_readTimeStep;
+  Variables m_readVariables;
+  int m_readHistogramBins;
+  bool m_readUseGlobalRanges;
+  VariableMetaDataMap m_readVariableMap;
+  vtkBoundingBox m_readBounds;
+  bool m_readGlobalRanges;
+  // The request that produced m_dataObject:
+  std::string m_loadedFileName;
+  int m_loadedTimeStep;
+  Variables m_loadedVariables;
+  int m_loadedHistogramBins;
+  size_t m_cacheBudget;
+
   int m_numberOfTimeSteps;
   int m_timeStep;
   int m_timeStepRange[2];
   double m_timeRange[2];
 
+  int m_histogramBins;
+
+  long long m_reducerVoxelBudget;
+  double m_reducerTimeBudget;
+  // The voxel count used by the adaptive reducer, after time budget scaling:
+  double m_reducerVoxels;
+  // Duration of the last resample, in seconds:
+  double m_reducerSeconds;
+  // The image cache key and result of executeReducer:
+  mvImageCache::Key m_reducerKey;
+  vtkSmartPointer<vtkDataObject> m_reducedResult;
+
   Variables m_availableVariables;
   Variables m_requestedVariables;
+
+  // Identify the reference mesh and the points of the latest request, see
+  // updateCellLocators():
+  std::vector<unsigned long long> m_locatorMesh;
+  std::vector<unsigned long long> m_locatorPoints;
+  // Shared with m_locatorThread, guarded by m_locatorMutex. Requests that
+  // arrive during a build replace each other, only the latest is built.
+  mutable std::mutex m_locatorMutex;
+  std::condition_variable m_locatorWake;
+  CellLocators m_cellLocators;
+  std::vector<vtkSmartPointer<vtkUnstructuredGrid> > m_locatorGrids;
+  bool m_locatorPending;
+  // The pending request only moved the points, see mvCellLocator::refit():
+  bool m_locatorRefit;
+  bool m_locatorQuit;
+  // Started by the first request, joined by the destructor:
+  std::thread m_locatorThread;
 };
 
 /**
@@ -171,6 +423,12 @@ struct mvReader::VariableMetaData
 
   Location location;
   double range[2];
+
+  /**
+   * Histogram of the first component, with mvReader::histogramBins() bins
+   * spanning range. Empty for non-numeric arrays.
+   */
+  std::vector<float> histogram;
 };
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,434 @@
+#include "mvSeriesStatistics.h"
+
+#include <vtkCellData.h>
+#include <vtkCompositeDataIterator.h>
+#include <vtkDataArray.h>
+#include <vtkDataSet.h>
+#include <vtkDoubleArray.h>
+#include <vtkExodusIIReader.h>
+#include <vtkFloatArray.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkPointData.h>
+
+#include "mvHistogram.h"
+#include "mvRange.h"
+#include "mvReader.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+//------------------------------------------------------------------------------
+// Identifies a version of the data file, so stale sidecars are ignored.
+bool fileSignature(const std::string &fileName, std::string &signature)
+{
+  struct stat info;
+  if (stat(fileName.c_str(), &info) != 0)
+    {
+    return false;
+    }
+
+  std::ostringstream str;
+  str << static_cast<long long>(info.st_size) << " "
+      << static_cast<long long>(info.st_mtime);
+  signature = str.str();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Same binning as mvHistogram, so that the series histograms line up with the
+// per-timestep ones.
+inline size_t binIndex(double value, double min, double scale)
+{
+  return static_cast<size_t>(mvHistogram::binIndex(
+                               value, min, scale,
+                               mvSeriesStatistics::NumberOfBins));
+}
+
+//------------------------------------------------------------------------------
+template <typename T>
+void binValues(const T *data, vtkIdType numTuples, int stride, double min,
+               double scale, std::vector<unsigned long long> &bins)
+{
+  for (vtkIdType i = 0; i < numTuples; ++i)
+    {
+    const T v = data[i * stride];
+    if (v == v) // Skip NaNs.
+      {
+      ++bins[binIndex(v, min, scale)];
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void binArray(vtkDataArray *array, const double range[2],
+              std::vector<unsigned long long> &bins)
+{
+  const vtkIdType numTuples = array->GetNumberOfTuples();
+  const int stride = array->GetNumberOfComponents();
+  const double min = range[0];
+  const double scale =
+      mvHistogram::binScale(range, mvSeriesStatistics::NumberOfBins);
+  if (vtkFloatArray *fa = vtkFloatArray::SafeDownCast(array))
+    {
+    binValues(fa->GetPointer(0), numTuples, stride, min, scale, bins);
+    }
+  else if (vtkDoubleArray *da = vtkDoubleArray::SafeDownCast(array))
+    {
+    binValues(da->GetPointer(0), numTuples, stride, min, scale, bins);
+    }
+  else
+    {
+    for (vtkIdType i = 0; i < numTuples; ++i)
+      {
+      const double v = array->GetComponent(i, 0);
+      if (v == v)
+        {
+        ++bins[binIndex(v, min, scale)];
+        }
+      }
+    }
+}
+
+} // end anon namespace
+
+//------------------------------------------------------------------------------
+mvSeriesStatistics::Variable::Variable()
+  : range{std::numeric_limits<double>::max(),
+          std::numeric_limits<double>::lowest()},
+    histogram(NumberOfBins, 0)
+{
+}
+
+//------------------------------------------------------------------------------
+mvSeriesStatistics::mvSeriesStatistics()
+  : m_quit(false),
+    m_complete(false),
+    m_stepsProcessed(0)
+{
+}
+
+//------------------------------------------------------------------------------
+mvSeriesStatistics::~mvSeriesStatistics()
+{
+  this->stop();
+}
+
+//------------------------------------------------------------------------------
+void mvSeriesStatistics::start(const std::string &fileName)
+{
+    {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (fileName == m_fileName)
+      {
+      return;
+      }
+    }
+
+  this->stop();
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_fileName = fileName;
+  m_variables.clear();
+  m_complete = false;
+  m_stepsProcessed = 0;
+
+  if (fileName.empty())
+    {
+    return;
+    }
+
+  if (this->load(fileName, m_variables))
+    {
+    m_complete = true;
+    return;
+    }
+
+  m_quit = false;
+  m_thread = std::thread(&mvSeriesStatistics::run, this, fileName);
+}
+
+//------------------------------------------------------------------------------
+void mvSeriesStatistics::stop()
+{
+  if (m_thread.joinable())
+    {
+    m_quit = true;
+    m_thread.join();
+    }
+}
+
+//------------------------------------------------------------------------------
+std::string mvSeriesStatistics::fileName() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_fileName;
+}
+
+//------------------------------------------------------------------------------
+bool mvSeriesStatistics::lookup(const std::string &variable,
+                                Variable &result) const
+{
+  if (!m_complete)
+    {
+    return false;
+    }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_variables.find(variable);
+  if (it == m_variables.end())
+    {
+    return false;
+    }
+
+  result = it->second;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+std::string mvSeriesStatistics::sidecarFileName(const std::string &fileName)
+{
+  return fileName + ".mvstats";
+}
+
+//------------------------------------------------------------------------------
+void mvSeriesStatistics::run(std::string fileName)
+{
+  int timeStepRange[2];
+    {
+    std::lock_guard<std::mutex> ioLock(mvReader::exodusMutex());
+    m_reader->SetFileName(fileName.c_str());
+    m_reader->UpdateInformation();
+    m_reader->GetTimeStepRange(timeStepRange);
+    }
+
+  VariableMap variables;
+  vtkNew<vtkMultiBlockDataSet> data;
+  for (int t = timeStepRange[0]; t <= timeStepRange[1]; ++t)
+    {
+    if (m_quit)
+      {
+      return;
+      }
+    if (!this->readTimeStep(t, data.GetPointer()))
+      {
+      std::cerr << "Series statistics: Failed to read timestep " << t
+                << " from '" << fileName << "'." << std::endl;
+      return;
+      }
+    this->accumulate(data.GetPointer(), variables);
+    ++m_stepsProcessed;
+    }
+
+  this->save(fileName, variables);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_variables.swap(variables);
+  m_complete = true;
+}
+
+//------------------------------------------------------------------------------
+bool mvSeriesStatistics::readTimeStep(int timeStep,
+                                      vtkMultiBlockDataSet *output)
+{
+  std::lock_guard<std::mutex> ioLock(mvReader::exodusMutex());
+
+  const int numPointArrays = m_reader->GetNumberOfPointResultArrays();
+  for (int i = 0; i < numPointArrays; ++i)
+    {
+    m_reader->SetPointResultArrayStatus(m_reader->GetPointResultArrayName(i),
+                                        1);
+    }
+  const int numElementArrays = m_reader->GetNumberOfElementResultArrays();
+  for (int i = 0; i < numElementArrays; ++i)
+    {
+    m_reader->SetElementResultArrayStatus(
+          m_reader->GetElementResultArrayName(i), 1);
+    }
+
+  m_reader->SetTimeStep(timeStep);
+  m_reader->Update();
+
+  vtkMultiBlockDataSet *result = m_reader->GetOutput();
+  if (!result)
+    {
+    return false;
+    }
+  output->ShallowCopy(result);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void mvSeriesStatistics::accumulate(vtkMultiBlockDataSet *data,
+                                    VariableMap &variables)
+{
+  // Gather the arrays of each variable:
+  std::map<std::string, std::vector<vtkDataArray*> > arrays;
+  vtkCompositeDataIterator *it = data->NewIterator();
+  for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+    {
+    vtkDataSet *ds = vtkDataSet::SafeDownCast(it->GetCurrentDataObject());
+    if (!ds)
+      {
+      continue;
+      }
+    vtkFieldData *fds[2] = { ds->GetPointData(), ds->GetCellData() };
+    for (vtkFieldData *fd : fds)
+      {
+      for (int i = 0; i < fd->GetNumberOfArrays(); ++i)
+        {
+        vtkDataArray *array = fd->GetArray(i);
+        if (array && array->GetName())
+          {
+          arrays[array->GetName()].push_back(array);
+          }
+        }
+      }
+    }
+  it->Delete();
+
+  for (const auto &var : arrays)
+    {
+    Variable &stats = variables[var.first];
+
+    // Expand the range:
+    double range[2] = { stats.range[0], stats.range[1] };
+    for (const mvRange::Range &r : mvRange::compute(var.second))
+      {
+      range[0] = std::min(range[0], r[0]);
+      range[1] = std::max(range[1], r[1]);
+      }
+    if (range[0] > range[1])
+      { // No values yet.
+      continue;
+      }
+
+    // Rebin the existing counts if the range grew. Each old bin is moved
+    // into the new bin containing its center. The last bin only holds the
+    // maximum, see mvHistogram, so its center is clamped to the old range.
+    if (range[0] != stats.range[0] || range[1] != stats.range[1])
+      {
+      std::vector<unsigned long long> bins(NumberOfBins, 0);
+      if (stats.range[0] <= stats.range[1])
+        {
+        const double oldScale = mvHistogram::binScale(stats.range,
+                                                      NumberOfBins);
+        const double scale = mvHistogram::binScale(range, NumberOfBins);
+        for (size_t b = 0; b < stats.histogram.size(); ++b)
+          {
+          const double center = oldScale > 0.
+              ? std::min(stats.range[0] + (b + 0.5) / oldScale,
+                         stats.range[1])
+              : stats.range[0];
+          bins[binIndex(center, range[0], scale)] += stats.histogram[b];
+          }
+        }
+      stats.histogram.swap(bins);
+      stats.range[0] = range[0];
+      stats.range[1] = range[1];
+      }
+
+    for (vtkDataArray *array : var.second)
+      {
+      binArray(array, stats.range, stats.histogram);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+bool mvSeriesStatistics::load(const std::string &fileName,
+                              VariableMap &variables)
+{
+  std::string signature;
+  if (!fileSignature(fileName, signature))
+    {
+    return false;
+    }
+
+  std::ifstream in(sidecarFileName(fileName).c_str());
+  if (!in)
+    {
+    return false;
+    }
+
+  // Header: "mvstats 2 <size> <mtime>"
+  std::string line;
+  if (!std::getline(in, line) || line != "mvstats 2 " + signature)
+    {
+    return false;
+    }
+
+  // Per variable: "variable <name>" followed by
+  // "<min> <max> <numBins> <counts...>"
+  VariableMap result;
+  while (std::getline(in, line))
+    {
+    const std::string prefix("variable ");
+    if (line.compare(0, prefix.size(), prefix) != 0)
+      {
+      return false;
+      }
+    Variable &stats = result[line.substr(prefix.size())];
+
+    int numBins = 0;
+    if (!(in >> stats.range[0] >> stats.range[1] >> numBins) ||
+        numBins != NumberOfBins)
+      {
+      return false;
+      }
+    for (int b = 0; b < numBins; ++b)
+      {
+      if (!(in >> stats.histogram[b]))
+        {
+        return false;
+        }
+      }
+    in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+
+  variables.swap(result);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool mvSeriesStatistics::save(const std::string &fileName,
+                              const VariableMap &variables)
+{
+  std::string signature;
+  if (!fileSignature(fileName, signature))
+    {
+    return false;
+    }
+
+  const std::string sidecar = sidecarFileName(fileName);
+  std::ofstream out(sidecar.c_str());
+  if (!out)
+    {
+    std::cerr << "Series statistics: Cannot write '" << sidecar << "'."
+              << std::endl;
+    return false;
+    }
+
+  out << "mvstats 2 " << signature << "\n"
+      << std::setprecision(std::numeric_limits<double>::max_digits10);
+  for (const auto &var : variables)
+    {
+    out << "variable " << var.first << "\n"
+        << var.second.range[0] << " " << var.second.range[1] << " "
+        << var.second.histogram.size();
+    for (unsigned long long count : var.second.histogram)
+      {
+      out << " " << count;
+      }
+    out << "\n";
+    }
+
+  return static_cast<bool>(out);
+}
@@ -0,0 +1,108 @@
+#ifndef MVSERIESSTATISTICS_H
+#define MVSERIESSTATISTICS_H
+
+#include <vtkNew.h>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class vtkExodusIIReader;
+class vtkMultiBlockDataSet;
+
+/**
+ * @brief The mvSeriesStatistics class computes the range and histogram of
+ * every variable over all timesteps of an Exodus II file.
+ *
+ * The per-timestep ranges reported by mvReader change as an animation plays,
+ * which makes the color map jump. This class streams every timestep once on a
+ * background thread and accumulates the global range and a histogram with
+ * NumberOfBins bins for each variable.
+ *
+ * Results are persisted to a sidecar file (the data file name with a
+ * ".mvstats" suffix) together with the data file's size and modification
+ * time, so later sessions load them instantly instead of rescanning the file.
+ *
+ * Statistics are only available once the whole series has been processed,
+ * see complete().
+ */
+class mvSeriesStatistics
+{
+public:
+  enum { NumberOfBins = 256 };
+
+  struct Variable
+  {
+    Variable();
+
+    double range[2];
+    // NumberOfBins counts of the first component, spanning range. Binned
+    // like mvHistogram.
+    std::vector<unsigned long long> histogram;
+  };
+
+  using VariableMap = std::map<std::string, Variable>;
+
+  mvSeriesStatistics();
+  ~mvSeriesStatistics();
+
+  /**
+   * Load the statistics of @a fileName from its sidecar file or start
+   * computing them in the background. Does nothing if @a fileName is already
+   * loaded or in progress.
+   */
+  void start(const std::string &fileName);
+
+  /** Abort the background pass, if any. */
+  void stop();
+
+  /** The data file that statistics are being provided for. */
+  std::string fileName() const;
+
+  /** True once statistics for the entire series are available. */
+  bool complete() const { return m_complete; }
+
+  /** Number of timesteps processed so far by the background pass. */
+  int stepsProcessed() const { return m_stepsProcessed; }
+
+  /**
+   * Copy the statistics for @a variable into @a result. Returns false if
+   * !complete() or @a variable is unknown.
+   */
+  bool lookup(const std::string &variable, Variable &result) const;
+
+  /** The name of the sidecar file for @a fileName. */
+  static std::string sidecarFileName(const std::string &fileName);
+
+private:
+  void run(std::string fileName);
+
+  // Read one timestep with all variables enabled:
+  bool readTimeStep(int timeStep, vtkMultiBlockDataSet *output);
+  // Merge the variables of @a data into @a variables:
+  static void accumulate(vtkMultiBlockDataSet *data, VariableMap &variables);
+
+  static bool load(const std::string &fileName, VariableMap &variables);
+  static bool save(const std::string &fileName, const VariableMap &variables);
+
+private:
+  // Not implemented -- disable copy:
+  mvSeriesStatistics(const mvSeriesStatistics&);
+  mvSeriesStatistics& operator=(const mvSeriesStatistics&);
+
+private:
+  vtkNew<vtkExodusIIReader> m_reader; // Only used by the worker thread.
+  std::thread m_thread;
+  std::atomic<bool> m_quit;
+  std::atomic<bool> m_complete;
+  std::atomic<int> m_stepsProcessed;
+
+  mutable std::mutex m_mutex;
+  std::string m_fileName;
+  VariableMap m_variables;
+};
+
+#endif // MVSERIESSTATISTICS_H
@@ -5,23 +5,27 @@
 #include <Geometry/Rotation.h>
 
 #include <vtkActor.h>
+#include <vtkAppendPolyData.h>
 #include <vtkCompositePolyDataMapper.h>
 #include <vtkCutter.h>
+#include <vtkDataSet.h>
 #include <vtkExternalOpenGLRenderer.h>
 #include <vtkFlyingEdgesPlaneCutter.h>
 #include <vtkImageData.h>
 #include <vtkLookupTable.h>
 #include <vtkMultiBlockDataSet.h>
 #include <vtkPlane.h>
+#include <vtkPolyData.h>
 #include <vtkPolyDataMapper.h>
 #include <vtkProperty.h>
-#include <vtkSampleImplicitFunctionFilter.h>
-#include <vtkSMPContourGrid.h>
+#include <vtkUnstructuredGrid.h>
 
 #include <vvContextState.h>
 
 #include "mvApplicationState.h"
+#include "mvBlockParallel.h"
 #include "mvInteractor.h"
+#include "mvPlaneCutter.h"
 #include "mvReader.h"
 
 #include <algorithm>
@@ -33,11 +37,14 @@ void mvSlice::SliceState::update(const vvApplicationState &vvState)
   const mvApplicationState &appState =
       static_cast<const mvApplicationState &>(vvState);
 
-  if (!this->visible || !appState.interactor().isInteracting())
+  if (!this->visible || !appState.interactor().isInteracting() ||
+      this->activePlane >= this->planes.size())
     {
     return;
     }
 
+  Plane &plane = this->planes[this->activePlane];
+
   switch (appState.interactor().state())
     {
     case mvInteractor::NoInteraction:
@@ -46,19 +53,19 @@ void mvSlice::SliceState::update(const vvApplicationState &vvState)
     case mvInteractor::Translating:
       {
       const Vrui::Vector &v = appState.interactor().current().getTranslation();
-      this->plane.origin[0] = v[0];
-      this->plane.origin[1] = v[1];
-      this->plane.origin[2] = v[2];
+      plane.origin[0] = v[0];
+      plane.origin[1] = v[1];
+      plane.origin[2] = v[2];
       }
       break;
 
     case mvInteractor::Rotating:
       {
       const Vrui::Rotation &rot = appState.interactor().delta().getRotation();
-      Vrui::Vector n(this->plane.normal.data());
+      Vrui::Vector n(plane.normal.data());
       n = rot.transform(n);
       std::copy(n.getComponents(), n.getComponents() + 3,
-                this->plane.normal.begin());
+                plane.normal.begin());
       }
       break;
 
@@ -72,12 +79,6 @@ void mvSlice::SliceState::update(const vvApplicationState &vvState)
 //------------------------------------------------------------------------------
 mvSlice::HintDataPipeline::HintDataPipeline()
 {
-  this->cutter->SetInputData(this->box.Get());
-  this->cutter->SetCutFunction(this->plane.Get());
-  this->cutter->GenerateTrianglesOn();
-  this->cutter->GenerateCutScalarsOff();
-  this->cutter->SetNumberOfContours(1);
-  this->cutter->SetValue(0, 0.);
 }
 
 //------------------------------------------------------------------------------
@@ -96,9 +97,37 @@ void mvSlice::HintDataPipeline::configure(const ObjectState &objState,
                         appState.reader().bounds().GetLength(1),
                         appState.reader().bounds().GetLength(2));
 
-  // Setup the plane:
-  this->plane->SetNormal(const_cast<double*>(sliceState.plane.normal.data()));
-  this->plane->SetOrigin(const_cast<double*>(sliceState.plane.origin.data()));
+  // Add or remove cutters to match the planes:
+  const size_t numPlanes = sliceState.planes.size();
+  if (this->cutters.size() != numPlanes)
+    {
+    this->planes.resize(numPlanes);
+    this->cutters.resize(numPlanes);
+    this->append->RemoveAllInputs();
+    for (size_t i = 0; i < numPlanes; ++i)
+      {
+      if (!this->cutters[i])
+        {
+        this->planes[i] = vtkSmartPointer<vtkPlane>::New();
+        this->cutters[i] = vtkSmartPointer<vtkCutter>::New();
+        this->cutters[i]->SetInputData(this->box.Get());
+        this->cutters[i]->SetCutFunction(this->planes[i]);
+        this->cutters[i]->GenerateTrianglesOn();
+        this->cutters[i]->GenerateCutScalarsOff();
+        this->cutters[i]->SetNumberOfContours(1);
+        this->cutters[i]->SetValue(0, 0.);
+        }
+      this->append->AddInputConnection(this->cutters[i]->GetOutputPort());
+      }
+    }
+
+  // Setup the planes:
+  for (size_t i = 0; i < numPlanes; ++i)
+    {
+    const Plane &plane = sliceState.planes[i];
+    this->planes[i]->SetNormal(const_cast<double*>(plane.normal.data()));
+    this->planes[i]->SetOrigin(const_cast<double*>(plane.origin.data()));
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -108,18 +137,34 @@ bool mvSlice::HintDataPipeline::needsUpdate(const ObjectState &objState,
   const SliceState& sliceState = static_cast<const SliceState&>(objState);
   const HintLODData& data = static_cast<const HintLODData&>(result);
 
-  return
-      sliceState.visible &&
-      (!data.slice.Get() ||
-       data.slice->GetMTime() < this->box->GetMTime() ||
-       data.slice->GetMTime() < this->plane->GetMTime() ||
-       data.slice->GetMTime() < this->cutter->GetMTime());
+  if (!sliceState.visible)
+    {
+    return false;
+    }
+
+  if (!data.slice.Get() ||
+      data.slice->GetMTime() < this->box->GetMTime() ||
+      data.slice->GetMTime() < this->append->GetMTime())
+    {
+    return true;
+    }
+
+  for (size_t i = 0; i < this->cutters.size(); ++i)
+    {
+    if (data.slice->GetMTime() < this->planes[i]->GetMTime() ||
+        data.slice->GetMTime() < this->cutters[i]->GetMTime())
+      {
+      return true;
+      }
+    }
+
+  return false;
 }
 
 //------------------------------------------------------------------------------
 void mvSlice::HintDataPipeline::execute()
 {
-  this->cutter->Update();
+  this->append->Update();
 }
 
 //------------------------------------------------------------------------------
@@ -127,7 +172,7 @@ void mvSlice::HintDataPipeline::exportResult(LODData &result) const
 {
   HintLODData& data = static_cast<HintLODData&>(result);
 
-  vtkDataObject *newSlice = this->cutter->GetOutputDataObject(0);
+  vtkDataObject *newSlice = this->append->GetOutputDataObject(0);
   data.slice.TakeReference(newSlice->NewInstance());
   data.slice->ShallowCopy(newSlice);
 }
@@ -177,9 +222,6 @@ void mvSlice::HintRenderPipeline::disable()
 //------------------------------------------------------------------------------
 mvSlice::LoResDataPipeline::LoResDataPipeline()
 {
-  this->cutter->SetPlane(this->plane.Get());
-  this->cutter->ComputeNormalsOff();
-  this->cutter->InterpolateAttributesOn();
 }
 
 //------------------------------------------------------------------------------
@@ -196,20 +238,40 @@ void mvSlice::LoResDataPipeline::configure(const ObjectState &objState,
   if (!metaData.valid() ||
       metaData.location != mvReader::VariableMetaData::Location::PointData)
     {
-    this->cutter->SetInputDataObject(nullptr);
+    this->input = nullptr;
     return;
     }
 
   // Use the reduced dataset:
-  this->cutter->SetInputDataObject(appState.reader().reducedDataObject());
-  this->cutter->SetInputArrayToProcess(0, 0, 0,
-                                       vtkDataObject::FIELD_ASSOCIATION_POINTS,
-                                       appState.colorByArray().c_str());
+  this->input = appState.reader().reducedDataObject();
+  this->arrayName = appState.colorByArray();
+
+  // One cutter per plane:
+  const size_t numPlanes = sliceState.planes.size();
+  this->planes.resize(numPlanes);
+  this->cutters.resize(numPlanes);
+  for (size_t i = 0; i < numPlanes; ++i)
+    {
+    if (!this->cutters[i])
+      {
+      this->planes[i] = vtkSmartPointer<vtkPlane>::New();
+      this->cutters[i] = vtkSmartPointer<vtkFlyingEdgesPlaneCutter>::New();
+      this->cutters[i]->SetPlane(this->planes[i]);
+      this->cutters[i]->ComputeNormalsOff();
+      this->cutters[i]->InterpolateAttributesOn();
+      }
 
+    vtkFlyingEdgesPlaneCutter *cutter = this->cutters[i];
+    cutter->SetInputDataObject(this->input);
+    cutter->SetInputArrayToProcess(0, 0, 0,
+                                   vtkDataObject::FIELD_ASSOCIATION_POINTS,
+                                   this->arrayName.c_str());
 
-  // Casts are for VTK (not const-correct)
-  this->plane->SetNormal(const_cast<double*>(sliceState.plane.normal.data()));
-  this->plane->SetOrigin(const_cast<double*>(sliceState.plane.origin.data()));
+    // Casts are for VTK (not const-correct)
+    const Plane &plane = sliceState.planes[i];
+    this->planes[i]->SetNormal(const_cast<double*>(plane.normal.data()));
+    this->planes[i]->SetOrigin(const_cast<double*>(plane.origin.data()));
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -219,18 +281,47 @@ bool mvSlice::LoResDataPipeline::needsUpdate(const ObjectState &objState,
   const SliceState& sliceState = static_cast<const SliceState&>(objState);
   const LoResLODData& data = static_cast<const LoResLODData&>(result);
 
-  return
-      sliceState.visible &&
-      this->cutter->GetInputDataObject(0, 0) &&
-      (!data.slice ||
-       data.slice->GetMTime() < this->plane->GetMTime() ||
-       data.slice->GetMTime() < this->cutter->GetMTime());
+  if (!sliceState.visible || !this->input)
+    {
+    return false;
+    }
+
+  // Also catches a change in the number of planes:
+  vtkMultiBlockDataSet *slices = vtkMultiBlockDataSet::SafeDownCast(data.slice);
+  if (!slices || slices->GetNumberOfBlocks() != this->cutters.size())
+    {
+    return true;
+    }
+
+  for (size_t i = 0; i < this->cutters.size(); ++i)
+    {
+    if (slices->GetMTime() < this->planes[i]->GetMTime() ||
+        slices->GetMTime() < this->cutters[i]->GetMTime())
+      {
+      return true;
+      }
+    }
+
+  return false;
 }
 
 //------------------------------------------------------------------------------
 void mvSlice::LoResDataPipeline::execute()
 {
-  this->cutter->Update();
+  vtkSmartPointer<vtkMultiBlockDataSet> slices =
+      vtkSmartPointer<vtkMultiBlockDataSet>::New();
+  slices->SetNumberOfBlocks(static_cast<unsigned int>(this->cutters.size()));
+  for (size_t i = 0; i < this->cutters.size(); ++i)
+    {
+    this->cutters[i]->Update();
+
+    vtkDataObject *slice = this->cutters[i]->GetOutputDataObject(0);
+    vtkSmartPointer<vtkDataObject> copy;
+    copy.TakeReference(slice->NewInstance());
+    copy->ShallowCopy(slice);
+    slices->SetBlock(static_cast<unsigned int>(i), copy);
+    }
+  this->output = slices;
 }
 
 //------------------------------------------------------------------------------
@@ -238,7 +329,7 @@ void mvSlice::LoResDataPipeline::exportResult(LODData &result) const
 {
   LoResLODData& data = static_cast<LoResLODData&>(result);
 
-  vtkDataObject *newSlice = this->cutter->GetOutputDataObject(0);
+  vtkDataObject *newSlice = this->output;
   data.slice.TakeReference(newSlice->NewInstance());
   data.slice->ShallowCopy(newSlice);
 }
@@ -319,23 +410,13 @@ void mvSlice::LoResRenderPipeline::disable()
 
 //------------------------------------------------------------------------------
 mvSlice::HiResDataPipeline::HiResDataPipeline()
+  : inputMTime(0)
 {
-  this->addPlane->SetImplicitFunction(this->plane.Get());
-  this->addPlane->ComputeGradientsOff();
-  this->addPlane->SetScalarArrayName("mvSlice Plane");
-
-  this->cutter->SetInputConnection(this->addPlane->GetOutputPort());
-  this->cutter->GenerateTrianglesOn();
-  this->cutter->ComputeScalarsOn();
-  this->cutter->SetNumberOfContours(1);
-  this->cutter->SetValue(0, 0.);
+}
 
-  // BUG: These options cause artifacts with the SMP filter. Reported as VTK
-  // bug 15969.
-//  this->contour->SetScalarTree(m_scalarTree.GetPointer());
-//  this->contour->UseScalarTreeOn();
-//  this->contour->MergePiecesOn();
-  this->cutter->MergePiecesOff();
+//------------------------------------------------------------------------------
+mvSlice::HiResDataPipeline::~HiResDataPipeline()
+{
 }
 
 //------------------------------------------------------------------------------
@@ -346,15 +427,18 @@ void mvSlice::HiResDataPipeline::configure(const ObjectState &objState,
       static_cast<const mvApplicationState &>(vvState);
   const SliceState& sliceState = static_cast<const SliceState&>(objState);
 
-  this->addPlane->SetInputDataObject(appState.reader().dataObject());
-
-  this->cutter->SetInputArrayToProcess(0, 0, 0,
-                                       vtkDataObject::FIELD_ASSOCIATION_POINTS,
-                                       "mvSlice Plane");
+  vtkDataObject *dObj = appState.reader().dataObject();
+  this->locators = appState.reader().cellLocators();
 
-  // Casts are for VTK (not const-correct)
-  this->plane->SetNormal(const_cast<double*>(sliceState.plane.normal.data()));
-  this->plane->SetOrigin(const_cast<double*>(sliceState.plane.origin.data()));
+  const unsigned long inputMTime = dObj ? dObj->GetMTime() : 0;
+  if (dObj != this->input.Get() || inputMTime != this->inputMTime ||
+      sliceState.planes != this->planes)
+    {
+    this->input = dObj;
+    this->inputMTime = inputMTime;
+    this->planes = sliceState.planes;
+    this->configureTime.Modified();
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -366,17 +450,88 @@ bool mvSlice::HiResDataPipeline::needsUpdate(const ObjectState &objState,
 
   return
       sliceState.visible &&
-      this->addPlane->GetInputDataObject(0, 0) &&
+      this->input &&
       (!data.slice ||
-       data.slice->GetMTime() < this->plane->GetMTime() ||
-       data.slice->GetMTime() < this->addPlane->GetMTime() ||
-       data.slice->GetMTime() < this->cutter->GetMTime());
+       data.slice->GetMTime() < this->configureTime.GetMTime());
 }
 
 //------------------------------------------------------------------------------
 void mvSlice::HiResDataPipeline::execute()
 {
-  this->cutter->Update();
+  const std::vector<vtkDataSet*> blocks = mvBlockParallel::blocks(this->input);
+
+  // Keep a cutter per block. Blocks that share their mesh with the previous
+  // input (e.g. the next timestep) reuse the prepared buffers and cuts.
+  while (this->cutters.size() < blocks.size())
+    {
+    this->cutters.emplace_back(new mvPlaneCutter);
+    }
+  this->cutters.resize(blocks.size());
+  this->cuts.resize(blocks.size());
+  const bool planesChanged = this->planes != this->cutPlanes;
+
+  std::vector<mvPlaneCutter::Plane> planes(this->planes.size());
+  for (size_t p = 0; p < planes.size(); ++p)
+    {
+    std::copy(this->planes[p].origin.begin(), this->planes[p].origin.end(),
+              planes[p].origin);
+    std::copy(this->planes[p].normal.begin(), this->planes[p].normal.end(),
+              planes[p].normal);
+    }
+
+  // outputs[i][p] is the cut of block i with plane p:
+  std::vector<std::vector<vtkSmartPointer<vtkPolyData> > > outputs(
+        blocks.size());
+  mvBlockParallel::forEach(blocks.size(), [&](size_t i)
+    {
+    mvPlaneCutter &cutter = *this->cutters[i];
+    std::vector<mvPlaneCutter::Cut> &cuts = this->cuts[i];
+    cutter.setInput(vtkUnstructuredGrid::SafeDownCast(blocks[i]));
+    if (!cutter.input())
+      {
+      cuts.clear();
+      return;
+      }
+
+    // Only recompute the topology when the planes or the mesh changed:
+    const bool current =
+        !planesChanged && cuts.size() == planes.size() &&
+        std::all_of(cuts.begin(), cuts.end(),
+                    [&](const mvPlaneCutter::Cut &cut)
+                      { return cutter.isCurrent(cut); });
+    if (!current)
+      {
+      const mvCellLocator *locator =
+          i < this->locators.size() ? this->locators[i].get() : nullptr;
+      cutter.cut(planes, cuts, locator);
+      }
+
+    outputs[i].resize(cuts.size());
+    for (size_t p = 0; p < cuts.size(); ++p)
+      {
+      outputs[i][p] = cutter.interpolate(cuts[p]);
+      }
+    });
+
+  vtkSmartPointer<vtkMultiBlockDataSet> slices =
+      vtkSmartPointer<vtkMultiBlockDataSet>::New();
+  slices->SetNumberOfBlocks(static_cast<unsigned int>(planes.size()));
+  for (size_t p = 0; p < planes.size(); ++p)
+    {
+    vtkSmartPointer<vtkMultiBlockDataSet> pieces =
+        vtkSmartPointer<vtkMultiBlockDataSet>::New();
+    pieces->SetNumberOfBlocks(static_cast<unsigned int>(outputs.size()));
+    for (size_t i = 0; i < outputs.size(); ++i)
+      {
+      if (p < outputs[i].size())
+        {
+        pieces->SetBlock(static_cast<unsigned int>(i), outputs[i][p]);
+        }
+      }
+    slices->SetBlock(static_cast<unsigned int>(p), pieces);
+    }
+  this->output = slices;
+  this->cutPlanes = this->planes;
 }
 
 //------------------------------------------------------------------------------
@@ -384,7 +539,7 @@ void mvSlice::HiResDataPipeline::exportResult(LODData &result) const
 {
   HiResLODData& data = static_cast<HiResLODData&>(result);
 
-  vtkDataObject *newSlice = this->cutter->GetOutputDataObject(0);
+  vtkDataObject *newSlice = this->output;
   data.slice.TakeReference(newSlice->NewInstance());
   data.slice->ShallowCopy(newSlice);
 }
@@ -3,12 +3,20 @@
 
 #include "vvLODAsyncGLObject.h"
 
+#include "mvPlaneCutter.h"
+
 #include <vtkNew.h>
 #include <vtkSmartPointer.h>
+#include <vtkTimeStamp.h>
 
+#include <algorithm>
+#include <memory>
+#include <string>
 #include <vector>
 
+class mvCellLocator;
 class vtkActor;
+class vtkAppendPolyData;
 class vtkCompositePolyDataMapper;
 class vtkCutter;
 class vtkDataObject;
@@ -16,13 +24,13 @@ class vtkFlyingEdgesPlaneCutter;
 class vtkImageData;
 class vtkPlane;
 class vtkPolyDataMapper;
-class vtkSampleImplicitFunctionFilter;
-class vtkSMPContourGrid;
 
 /**
  * @brief The mvSlice class implements dataset slicing.
  *
- * mvSlice renders a slice (see plane()) cut from the dataset.
+ * mvSlice renders one or more slices (see planes()) cut from the dataset.
+ * All planes are cut together: at full resolution, the cell culling and the
+ * point loads are shared by the planes (see mvPlaneCutter).
  */
 class mvSlice : public vvLODAsyncGLObject
 {
@@ -33,24 +41,33 @@ public:
   {
     std::array<double, 3> normal{{1., 1., 1.}};
     std::array<double, 3> origin{{0., 0., 0.}};
+
+    bool operator==(const Plane &o) const
+    {
+      return this->normal == o.normal && this->origin == o.origin;
+    }
+    bool operator!=(const Plane &o) const { return !(*this == o); }
   };
 
   // Slice state: --------------------------------------------------------------
   struct SliceState : public Superclass::ObjectState
   {
     void update(const vvApplicationState &appState) override;
-    Plane plane;
+    std::vector<Plane> planes{Plane()};
+    // The plane moved by the interactor:
+    size_t activePlane{0};
     bool visible{false};
   };
 
   // Hint LOD: -----------------------------------------------------------------
-  // Renders a simple plane cut from the dataset's boundaries.
+  // Renders simple plane cuts from the dataset's boundaries.
   // No scalar lookups.
   struct HintDataPipeline : public Superclass::DataPipeline
   {
-    vtkNew<vtkPlane> plane;
     vtkNew<vtkImageData> box;
-    vtkNew<vtkCutter> cutter;
+    std::vector<vtkSmartPointer<vtkPlane> > planes;
+    std::vector<vtkSmartPointer<vtkCutter> > cutters;
+    vtkNew<vtkAppendPolyData> append;
 
     HintDataPipeline();
 
@@ -86,12 +103,17 @@ public:
   };
 
   // LoRes LOD: ----------------------------------------------------------------
-  // Uses vtkFlyingEdgesPlaneCutter to quickly extract a slice of the reduced
-  // dataset.
+  // Uses vtkFlyingEdgesPlaneCutter to quickly extract the slices of the
+  // reduced dataset. The result has one block per plane.
   struct LoResDataPipeline : public Superclass::DataPipeline
   {
-    vtkNew<vtkPlane> plane;
-    vtkNew<vtkFlyingEdgesPlaneCutter> cutter;
+    std::vector<vtkSmartPointer<vtkPlane> > planes;
+    std::vector<vtkSmartPointer<vtkFlyingEdgesPlaneCutter> > cutters;
+    vtkSmartPointer<vtkDataObject> output;
+
+    // Current configuration:
+    vtkSmartPointer<vtkDataObject> input;
+    std::string arrayName;
 
     LoResDataPipeline();
     void configure(const ObjectState &objState,
@@ -123,14 +145,32 @@ public:
   };
 
   // HiRes LOD: ----------------------------------------------------------------
-  // Uses vtkSMPContourGrid to cut a slice from the full dataset.
+  // Cuts the slices from the full dataset with mvPlaneCutter, one cutter per
+  // block. Cutters keep their prepared mesh between plane moves and
+  // timesteps, and blocks are cut concurrently (see mvBlockParallel). All
+  // planes are cut in a single pass over each block. Once the reader's cell
+  // locators are available, only the cells near the planes are visited.
+  // The cuts of each block are kept while its mesh and the planes are
+  // unchanged, so a new timestep only re-interpolates its arrays.
+  // The result has one block per plane, each with one polydata per block.
   struct HiResDataPipeline : public Superclass::DataPipeline
   {
-    vtkNew<vtkPlane> plane;
-    vtkNew<vtkSampleImplicitFunctionFilter> addPlane;
-    vtkNew<vtkSMPContourGrid> cutter;
+    std::vector<std::unique_ptr<mvPlaneCutter> > cutters;
+    vtkSmartPointer<vtkDataObject> output;
+
+    // cuts[i][p] is the cut of block i with plane p, for cutPlanes:
+    std::vector<std::vector<mvPlaneCutter::Cut> > cuts;
+    std::vector<Plane> cutPlanes;
+
+    // Current configuration:
+    vtkSmartPointer<vtkDataObject> input;
+    std::vector<std::shared_ptr<const mvCellLocator> > locators;
+    unsigned long inputMTime;
+    std::vector<Plane> planes;
+    vtkTimeStamp configureTime;
 
     HiResDataPipeline();
+    ~HiResDataPipeline();
     void configure(const ObjectState &objState,
                    const vvApplicationState &appState) override;
     bool needsUpdate(const ObjectState &objState,
@@ -170,7 +210,20 @@ public:
   void setVisible(bool visible);
 
   /**
-   * The slice plane.
+   * The slice planes. At least one plane is always present; setting an empty
+   * list is ignored.
+   */
+  const std::vector<Plane>& planes() const;
+  void setPlanes(const std::vector<Plane> &planes);
+
+  /**
+   * The plane that follows the interactor. Out of range indices are clamped.
+   */
+  size_t activePlane() const;
+  void setActivePlane(size_t index);
+
+  /**
+   * The active slice plane.
    */
   const Plane& plane() const;
   void setPlane(const Plane &p);
@@ -202,16 +255,48 @@ inline void mvSlice::setVisible(bool v)
   this->objectState<SliceState>().visible = v;
 }
 
+//------------------------------------------------------------------------------
+inline const std::vector<mvSlice::Plane> &mvSlice::planes() const
+{
+  return this->objectState<SliceState>().planes;
+}
+
+//------------------------------------------------------------------------------
+inline void mvSlice::setPlanes(const std::vector<mvSlice::Plane> &p)
+{
+  if (!p.empty())
+    {
+    SliceState &state = this->objectState<SliceState>();
+    state.planes = p;
+    state.activePlane = std::min(state.activePlane, p.size() - 1);
+    }
+}
+
+//------------------------------------------------------------------------------
+inline size_t mvSlice::activePlane() const
+{
+  return this->objectState<SliceState>().activePlane;
+}
+
+//------------------------------------------------------------------------------
+inline void mvSlice::setActivePlane(size_t index)
+{
+  SliceState &state = this->objectState<SliceState>();
+  state.activePlane = std::min(index, state.planes.size() - 1);
+}
+
 //------------------------------------------------------------------------------
 inline const mvSlice::Plane &mvSlice::plane() const
 {
-  return this->objectState<SliceState>().plane;
+  const SliceState &state = this->objectState<SliceState>();
+  return state.planes[state.activePlane];
 }
 
 //------------------------------------------------------------------------------
 inline void mvSlice::setPlane(const mvSlice::Plane &p)
 {
-  this->objectState<SliceState>().plane = p;
+  SliceState &state = this->objectState<SliceState>();
+  state.planes[state.activePlane] = p;
 }
 
 #endif // MVSLICES_H
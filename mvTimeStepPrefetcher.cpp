@@ -0,0 +1,282 @@
+#include "mvTimeStepPrefetcher.h"
+
+#include <vtkExodusIIReader.h>
+#include <vtkMultiBlockDataSet.h>
+
+#include "mvReader.h"
+
+#include <algorithm>
+#include <iostream>
+
+//------------------------------------------------------------------------------
+mvTimeStepPrefetcher::mvTimeStepPrefetcher()
+  : m_quit(false),
+    m_timeStep(0),
+    m_timeStepRange{0, 0},
+    m_stepsAhead(0),
+    m_stepsBehind(0)
+{
+  // Like mvReader, read the undisplaced mesh so it can be shared:
+  m_reader->ApplyDisplacementsOff();
+}
+
+//------------------------------------------------------------------------------
+mvTimeStepPrefetcher::~mvTimeStepPrefetcher()
+{
+  this->stop();
+}
+
+//------------------------------------------------------------------------------
+int mvTimeStepPrefetcher::stepsAhead() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stepsAhead;
+}
+
+//------------------------------------------------------------------------------
+void mvTimeStepPrefetcher::setStepsAhead(int steps)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_stepsAhead = std::max(0, steps);
+  m_wake.notify_one();
+}
+
+//------------------------------------------------------------------------------
+int mvTimeStepPrefetcher::stepsBehind() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stepsBehind;
+}
+
+//------------------------------------------------------------------------------
+void mvTimeStepPrefetcher::setStepsBehind(int steps)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_stepsBehind = std::max(0, steps);
+  m_wake.notify_one();
+}
+
+//------------------------------------------------------------------------------
+void mvTimeStepPrefetcher::request(const std::string &fileName,
+                                   const Variables &variables,
+                                   int timeStep, const int range[2])
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  if (m_stepsAhead == 0 && m_stepsBehind == 0)
+    {
+    m_ring.clear();
+    return;
+    }
+
+  if (fileName != m_fileName || variables != m_variables ||
+      range[0] != m_timeStepRange[0] || range[1] != m_timeStepRange[1])
+    {
+    m_ring.clear();
+    m_fileName = fileName;
+    m_variables = variables;
+    m_timeStepRange[0] = range[0];
+    m_timeStepRange[1] = range[1];
+    }
+  else if (timeStep == m_timeStep)
+    {
+    return; // Nothing changed.
+    }
+
+  m_timeStep = timeStep;
+
+  // Drop entries that fell out of the window:
+  std::vector<int> window = this->windowSteps();
+  for (auto it = m_ring.begin(); it != m_ring.end();)
+    {
+    if (std::find(window.begin(), window.end(), it->first) == window.end())
+      {
+      it = m_ring.erase(it);
+      }
+    else
+      {
+      ++it;
+      }
+    }
+
+  lock.unlock();
+  this->start();
+  m_wake.notify_one();
+}
+
+//------------------------------------------------------------------------------
+vtkSmartPointer<vtkMultiBlockDataSet>
+mvTimeStepPrefetcher::lookup(const std::string &fileName, int timeStep,
+                             const Variables &variables)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (fileName != m_fileName || variables != m_variables)
+    {
+    return nullptr;
+    }
+
+  auto it = m_ring.find(timeStep);
+  return it != m_ring.end() ? it->second : nullptr;
+}
+
+//------------------------------------------------------------------------------
+void mvTimeStepPrefetcher::run()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (!m_quit)
+    {
+    // Find the most urgent timestep that hasn't been read yet. The current
+    // timestep is skipped, mvReader is already reading it.
+    int next = -1;
+    std::vector<int> window = this->windowSteps();
+    for (size_t i = 1; i < window.size(); ++i)
+      {
+      if (m_ring.find(window[i]) == m_ring.end())
+        {
+        next = window[i];
+        break;
+        }
+      }
+
+    if (next < 0 || m_fileName.empty())
+      {
+      m_wake.wait(lock);
+      continue;
+      }
+
+    const std::string fileName = m_fileName;
+    const Variables variables = m_variables;
+
+    lock.unlock();
+    vtkSmartPointer<vtkMultiBlockDataSet> data =
+        this->read(fileName, variables, next);
+    lock.lock();
+
+    // Only keep the result if it still matches the current configuration:
+    if (fileName == m_fileName && variables == m_variables)
+      {
+      window = this->windowSteps();
+      if (std::find(window.begin(), window.end(), next) != window.end())
+        {
+        m_ring[next] = data;
+        }
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void mvTimeStepPrefetcher::start()
+{
+  if (!m_thread.joinable())
+    {
+    m_thread = std::thread(&mvTimeStepPrefetcher::run, this);
+    }
+}
+
+//------------------------------------------------------------------------------
+void mvTimeStepPrefetcher::stop()
+{
+  if (m_thread.joinable())
+    {
+      {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_quit = true;
+      }
+    m_wake.notify_one();
+    m_thread.join();
+    }
+}
+
+//------------------------------------------------------------------------------
+std::vector<int> mvTimeStepPrefetcher::windowSteps() const
+{
+  std::vector<int> result;
+
+  const int first = m_timeStepRange[0];
+  const int count = m_timeStepRange[1] - m_timeStepRange[0] + 1;
+  if (count <= 0)
+    {
+    return result;
+    }
+
+  // Wrap offsets around the timestep range:
+  auto wrap = [&](int offset) -> int
+  {
+    int idx = (m_timeStep - first + offset) % count;
+    return first + (idx < 0 ? idx + count : idx);
+  };
+
+  auto append = [&](int step)
+  {
+    if (std::find(result.begin(), result.end(), step) == result.end())
+      {
+      result.push_back(step);
+      }
+  };
+
+  append(wrap(0));
+
+  // Interleave ahead/behind so that short reversals stay cheap:
+  const int maxOffset = std::max(m_stepsAhead, m_stepsBehind);
+  for (int offset = 1; offset <= maxOffset; ++offset)
+    {
+    if (offset <= m_stepsAhead)
+      {
+      append(wrap(offset));
+      }
+    if (offset <= m_stepsBehind)
+      {
+      append(wrap(-offset));
+      }
+    }
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+vtkSmartPointer<vtkMultiBlockDataSet>
+mvTimeStepPrefetcher::read(const std::string &fileName,
+                           const Variables &variables, int timeStep)
+{
+  std::lock_guard<std::mutex> ioLock(mvReader::exodusMutex());
+
+  if (fileName != m_readerFileName)
+    {
+    m_reader->SetFileName(fileName.c_str());
+    m_readerFileName = fileName;
+    }
+  m_reader->UpdateInformation();
+
+  // Sync variables:
+  const int numPointArrays = m_reader->GetNumberOfPointResultArrays();
+  for (int i = 0; i < numPointArrays; ++i)
+    {
+    const char *array = m_reader->GetPointResultArrayName(i);
+    m_reader->SetPointResultArrayStatus(
+          array, variables.find(array) != variables.end() ? 1 : 0);
+    }
+  const int numElementArrays = m_reader->GetNumberOfElementResultArrays();
+  for (int i = 0; i < numElementArrays; ++i)
+    {
+    const char *array = m_reader->GetElementResultArrayName(i);
+    m_reader->SetElementResultArrayStatus(
+          array, variables.find(array) != variables.end() ? 1 : 0);
+    }
+
+  m_reader->SetTimeStep(timeStep);
+  m_reader->Update();
+
+  vtkMultiBlockDataSet *output = m_reader->GetOutput();
+  if (!output)
+    {
+    std::cerr << "Prefetch of timestep " << timeStep << " from '" << fileName
+              << "' failed." << std::endl;
+    return nullptr;
+    }
+
+  vtkSmartPointer<vtkMultiBlockDataSet> result;
+  result.TakeReference(output->NewInstance());
+  result->ShallowCopy(output);
+  return result;
+}
@@ -0,0 +1,109 @@
+#ifndef MVTIMESTEPPREFETCHER_H
+#define MVTIMESTEPPREFETCHER_H
+
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+class vtkExodusIIReader;
+class vtkMultiBlockDataSet;
+
+/**
+ * @brief The mvTimeStepPrefetcher class keeps a ring of decoded timesteps
+ * around the current timestep of an Exodus II file.
+ *
+ * A background worker reads the stepsAhead() timesteps following (and the
+ * stepsBehind() timesteps preceding) the step passed to request(), so that
+ * mvReader can serve animation playback from memory. The ring wraps around
+ * the timestep range, so looped playback stays warm.
+ *
+ * The worker uses its own vtkExodusIIReader, but all Exodus I/O is
+ * serialized through mvReader::exodusMutex() since the underlying netCDF
+ * library is not thread-safe. Prefetching therefore overlaps file reads with
+ * rendering, not with other reads.
+ */
+class mvTimeStepPrefetcher
+{
+public:
+  using Variables = std::set<std::string>;
+
+  mvTimeStepPrefetcher();
+  ~mvTimeStepPrefetcher();
+
+  /**
+   * The number of timesteps to keep decoded after / before the current one.
+   * Setting both to zero disables prefetching. @{
+   */
+  int stepsAhead() const;
+  void setStepsAhead(int steps);
+  int stepsBehind() const;
+  void setStepsBehind(int steps);
+  /** @} */
+
+  /**
+   * Recenter the ring on @a timeStep. Entries that were read from a different
+   * file or with a different variable set are discarded. @a range is the
+   * inclusive range of valid timesteps.
+   */
+  void request(const std::string &fileName, const Variables &variables,
+               int timeStep, const int range[2]);
+
+  /**
+   * Returns the decoded dataset for @a timeStep if it is in the ring and was
+   * read from @a fileName with exactly @a variables loaded, or nullptr
+   * otherwise. The returned object must be treated as read-only.
+   * This method is thread-safe.
+   */
+  vtkSmartPointer<vtkMultiBlockDataSet> lookup(const std::string &fileName,
+                                               int timeStep,
+                                               const Variables &variables);
+
+private:
+  void run();
+  void start();
+  void stop();
+
+  // Returns the timesteps in the ring, in the order they should be read.
+  // The current timestep is first. m_mutex must be held.
+  std::vector<int> windowSteps() const;
+
+  // Reads a timestep with the worker's reader. m_mutex must not be held.
+  vtkSmartPointer<vtkMultiBlockDataSet> read(const std::string &fileName,
+                                             const Variables &variables,
+                                             int timeStep);
+
+private:
+  // Not implemented -- disable copy:
+  mvTimeStepPrefetcher(const mvTimeStepPrefetcher&);
+  mvTimeStepPrefetcher& operator=(const mvTimeStepPrefetcher&);
+
+private:
+  // Protects everything below except m_reader, which only the worker uses.
+  mutable std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::thread m_thread;
+  bool m_quit;
+
+  std::string m_fileName;
+  Variables m_variables;
+  int m_timeStep;
+  int m_timeStepRange[2];
+  int m_stepsAhead;
+  int m_stepsBehind;
+
+  // Decoded timesteps. Failed reads are stored as nullptr so they are not
+  // retried until the configuration changes.
+  std::map<int, vtkSmartPointer<vtkMultiBlockDataSet> > m_ring;
+
+  vtkNew<vtkExodusIIReader> m_reader;
+  std::string m_readerFileName;
+};
+
+#endif // MVTIMESTEPPREFETCHER_H
@@ -175,9 +175,51 @@ void mvVolume::VolumeRenderPipeline::disable()
 
 //------------------------------------------------------------------------------
 mvVolume::HiResDataPipeline::HiResDataPipeline()
+  : inputMTime(0),
+    targetDimension(0),
+    cache(nullptr),
+    uncachedDimension(0),
+    exportedDimension(0)
 {
 }
 
+//------------------------------------------------------------------------------
+std::vector<int> mvVolume::HiResDataPipeline::pyramid() const
+{
+  std::vector<int> result;
+  for (int dim = 32; dim < this->targetDimension; dim *= 2)
+    {
+    result.push_back(dim);
+    }
+  result.push_back(this->targetDimension);
+  return result;
+}
+
+//------------------------------------------------------------------------------
+mvImageCache::Key mvVolume::HiResDataPipeline::levelKey(int dimension) const
+{
+  mvImageCache::Key result = this->key;
+  result.dimensions[0] = dimension;
+  result.dimensions[1] = dimension;
+  result.dimensions[2] = dimension;
+  return result;
+}
+
+//------------------------------------------------------------------------------
+int mvVolume::HiResDataPipeline::bestLevel() const
+{
+  const std::vector<int> levels = this->pyramid();
+  for (auto it = levels.rbegin(); it != levels.rend(); ++it)
+    {
+    if (*it == this->uncachedDimension ||
+        this->cache->contains(this->levelKey(*it)))
+      {
+      return *it;
+      }
+    }
+  return 0;
+}
+
 //------------------------------------------------------------------------------
 void mvVolume::HiResDataPipeline::configure(const ObjectState &objState,
                                             const vvApplicationState &vvState)
@@ -186,10 +228,28 @@ void mvVolume::HiResDataPipeline::configure(const ObjectState &objState,
       static_cast<const mvApplicationState &>(vvState);
   const VolumeState &state = static_cast<const VolumeState&>(objState);
 
-  this->filter->SetInputDataObject(appState.reader().dataObject());
-  this->filter->SetSamplingDimensions(state.dimension, state.dimension,
-                                      state.dimension);
+  // Start over when the data changes:
+  vtkDataObject *dObj = appState.reader().dataObject();
+  if (dObj != this->input.Get() ||
+      (dObj && dObj->GetMTime() != this->inputMTime))
+    {
+    this->input = dObj;
+    this->inputMTime = dObj ? dObj->GetMTime() : 0;
+    this->exportedDimension = 0;
+    this->uncached = nullptr;
+    this->uncachedDimension = 0;
+    }
+
+  // The displayed volume is finer than the new pyramid:
+  if (state.dimension < this->exportedDimension)
+    {
+    this->exportedDimension = 0;
+    }
 
+  this->targetDimension = state.dimension;
+  this->cache = &appState.reader().imageCache();
+  this->key = appState.reader().imageCacheKey();
+  this->filter->SetInputDataObject(dObj);
 }
 
 //------------------------------------------------------------------------------
@@ -201,24 +261,69 @@ bool mvVolume::HiResDataPipeline::needsUpdate(const ObjectState &objState,
 
   return
       state.visible &&
-      this->filter->GetInputDataObject(0, 0) &&
+      this->input &&
       (!data.volume ||
-       data.volume->GetMTime() < this->filter->GetMTime());
+       data.volume->GetMTime() < this->inputMTime ||
+       data.dimension != this->targetDimension);
 }
 
 //------------------------------------------------------------------------------
 void mvVolume::HiResDataPipeline::execute()
 {
-  this->filter->Update();
+  // If a finer level than the one displayed is already available, just
+  // export it:
+  if (this->bestLevel() > this->exportedDimension)
+    {
+    return;
+    }
+
+  // Levels up to the displayed one may have been evicted since they were
+  // exported. They are not needed anymore, so don't recompute them:
+  for (int dim : this->pyramid())
+    {
+    const mvImageCache::Key levelKey = this->levelKey(dim);
+    if (dim <= this->exportedDimension || dim == this->uncachedDimension ||
+        this->cache->contains(levelKey))
+      {
+      continue;
+      }
+
+    this->filter->SetSamplingDimensions(dim, dim, dim);
+    this->filter->Update();
+    vtkDataObject *dObj = this->filter->GetOutputDataObject(0);
+    this->cache->store(levelKey, dObj);
+
+    // Hold on to levels that are too large for the cache:
+    if (!this->cache->contains(levelKey))
+      {
+      this->uncached.TakeReference(dObj->NewInstance());
+      this->uncached->ShallowCopy(dObj);
+      this->uncachedDimension = dim;
+      }
+    return;
+    }
 }
 
 //------------------------------------------------------------------------------
 void mvVolume::HiResDataPipeline::exportResult(LODData &result) const
 {
   VolumeLODData &data = static_cast<VolumeLODData&>(result);
-  vtkDataObject *dObj = this->filter->GetOutputDataObject(0);
-  data.volume.TakeReference(dObj->NewInstance());
-  data.volume->ShallowCopy(dObj);
+  // Never go back to a coarser level than the one displayed:
+  const int best = this->bestLevel();
+  if (best == 0 || best <= this->exportedDimension)
+    {
+    return;
+    }
+
+  vtkSmartPointer<vtkDataObject> level = best == this->uncachedDimension
+      ? this->uncached : this->cache->find(this->levelKey(best));
+  if (level)
+    {
+    data.volume.TakeReference(level->NewInstance());
+    data.volume->ShallowCopy(level);
+    data.dimension = best;
+    this->exportedDimension = best;
+    }
 }
 
 //------------------------------------------------------------------------------
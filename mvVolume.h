@@ -3,10 +3,13 @@
 
 #include "vvLODAsyncGLObject.h"
 
+#include "mvImageCache.h"
+
 #include <vtkNew.h>
 #include <vtkSmartPointer.h>
 
 #include <string>
+#include <vector>
 
 class vtkColorTransferFunction;
 class vtkDataObject;
@@ -53,7 +56,9 @@ public:
   // LODData is shared by both LoRes and HiRes LODs.
   struct VolumeLODData : public Superclass::LODData
   {
+    VolumeLODData() : dimension(0) {}
     vtkSmartPointer<vtkDataObject> volume;
+    int dimension; // Sampling dimension of volume, HiRes only.
   };
 
   // RenderPipeline is shared by both LoRes and HiRes LODs.
@@ -77,11 +82,34 @@ public:
   };
 
   // HiRes LOD: ----------------------------------------------------------------
-  // Create a higher quality volume from the full dataset.
+  // Create a higher quality volume from the full dataset. The volume is built
+  // progressively as a pyramid of increasing sampling dimensions (32, 64, ...,
+  // VolumeState::dimension), one level per execution. Each level is exported
+  // as soon as it is ready, and needsUpdate() keeps requesting executions
+  // until the requested dimension is shown. Levels are stored in the reader's
+  // mvImageCache, so returning to a previous dimension or timestep is served
+  // immediately, and the 64^3 level is shared with the reduced dataset.
   struct HiResDataPipeline : public Superclass::DataPipeline
   {
     vtkNew<vtkResampleToImage> filter;
 
+    vtkSmartPointer<vtkDataObject> input;
+    unsigned long inputMTime;
+    int targetDimension;
+    mvImageCache *cache;
+    mvImageCache::Key key; // For input, dimensions are set per level.
+    // The last level if it was too large for the cache:
+    vtkSmartPointer<vtkDataObject> uncached;
+    int uncachedDimension;
+    mutable int exportedDimension;
+
+    // The pyramid levels leading up to targetDimension, coarsest first:
+    std::vector<int> pyramid() const;
+    // The cache key for the level with @a dimension:
+    mvImageCache::Key levelKey(int dimension) const;
+    // The finest cached pyramid level, or 0:
+    int bestLevel() const;
+
     HiResDataPipeline();
     void configure(const ObjectState &objState,
                    const vvApplicationState &appState) override;